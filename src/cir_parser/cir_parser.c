@@ -1,21 +1,26 @@
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
-#include <errno.h>
 #include <ctype.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "cir_parser.h"
 #include "../hashtable/hashtable.h"
 #include "../spicy.h"
 #include "../lists/lists.h"
+#include "../tokenizer/tokenizer.h"
+#include "../numparse/numparse.h"
+#include "../netcache/netcache.h"
 
 
 // converts a string to uppercase string
 void strtoupper(char *str) {
-	int i;
 
-	for (i=0; i < (int)strlen(str); i++) {
-		str[i] = toupper(str[i]);
+	for (; *str != '\0'; str++) {
+		*str = toupper(*str);
 	}
 }
 
@@ -98,27 +103,17 @@ void parse_command(char *command) {
 }
 
 
-// return 1 if str can be converted to a double, otherwise 0
+// return 1 if str can be converted to a double, otherwise 0.
+// Values may carry a SPICE scale factor (e.g. 10k, 2.2MEG, 5u, 1p)
 byte parse_double(double *d, char *str) {
-	char *end_ptr = str;
-
-	errno = 0;	// errno.h's errno
-
-	*d = strtod(str, &end_ptr);
-
-	// overflow or underflow
-	if (errno != 0)
-		return 0;
-
-	// no convertion applied
-	if (str == end_ptr)
-		return 0;
+	return num_parse(d, str, '\0');
+}
 
-	// trailing characters
-	if (*end_ptr != 0)
-		return 0;
 
-	return 1;
+// same as parse_double, but the value ends at the first stop character
+// (e.g. the ',' or ')' of a transient function argument)
+byte parse_double_until(double *d, char *str, char stop) {
+	return num_parse(d, str, stop);
 }
 
 
@@ -158,34 +153,25 @@ int whitespaces_only(char *line) {
 
 
 
-unsigned long get_components_num(char *filename) {
-	FILE *fp = NULL;
-	char *line = NULL;
-	size_t len = 0;
-	unsigned long components_num = 0;
-
-	fp = fopen(filename, "r");
-	if (fp == NULL) {
-		perror("fopen");
-		exit(EXIT_FAILURE);
-	}
-
-	while(getline(&line, &len, fp) != -1) {
-		if (component_type_is_valid(line[0]))
-				components_num++;
-	}
-
-	free(line);
-	fclose(fp);
-	return components_num;
-}
-
-
+// reports an error of parse_line(). The workers of the parallel parser pass an
+// err buffer: the message is kept there and the line returns PARSED_ERROR, so
+// that the merge reports the first error in file order. Otherwise it is printed
+// and the error path goes on to exit
+#define PARSE_ERROR(...)	do { \
+								if (err != NULL) { \
+									snprintf(err, PARSE_ERR_SIZE, __VA_ARGS__); \
+									return PARSED_ERROR; \
+								} \
+								printf(__VA_ARGS__); \
+							} while (0)
 
-// parse the Circuit file
-void parse_cir(char *filename) {
 
-	FILE *fp = NULL;
+// parses a line of the netlist into P, in place. The fields of P point into
+// the line. Lines are parsed independently of each other, without touching the
+// node table or the lists, so this can run on several lines concurrently.
+// Returns PARSED_NONE (empty or comment line), PARSED_COMPONENT or PARSED_COMMAND,
+// or PARSED_ERROR for a bad line when err is given
+byte parse_line(char *line, parsed_line *P, byte verbose, char *err) {
 
 	byte has_G2 = 0;			// "G2" Optional Variable of I, R, C
 	char type = 'X';			// Component Type: V, I, R, C, L, D, M, Q (unknown = X)
@@ -201,22 +187,14 @@ void parse_cir(char *filename) {
 	double w = -1;				// holds W value of MOS transistor
 
 
-	// hashtable entry field variables
-	unsigned long id = 0;
-	element_h *node1 = NULL;
-	element_h *node2 = NULL;
-	element_h *node3 = NULL;
-	element_h *node4 = NULL;
-
 	// used for parsing
-	char *line = NULL;		// the line parsed
 	char *line_pos;			// used to point at a line's byte
-	size_t len = 0;			// the length of the line parsed
 
 
-	// variables used with strtok
+	// variables used with strtok_r
 	const char delim[5] = " \r\t\n";
 	char *token = NULL;
+	char *save_ptr = NULL;
 	unsigned int tok_count = 0;
 	unsigned int min_tok_count = 0;
 	byte rest_line_commented = 0;
@@ -230,215 +208,511 @@ void parse_cir(char *filename) {
 	double v1, v2, v3, v4, v5, v6, v7;
 	double *times, *values;
 	unsigned int total_tuples;
-	char tmp_str[64];
 	int flag = 1;
 	int idx;
 
 	int i;
 
-	fp = fopen(filename, "r");
-	if (fp == NULL) {
-		perror("fopen");
-		exit(EXIT_FAILURE);
-	}
 
+	// bypass possible non ascii characters (for some reason they exist in a benchmark)
+	line_offset = 0;
+	while ((line[line_offset] < 0) || (line[line_offset] > 127)) { line_offset++; }
 
-	// read the file line-by-line
-	while((getline(&line, &len, fp)) != -1) {
 
-		// bypass possible non ascii characters (for some reason they exist in a benchmark)
-		line_offset = 0;
-		while ((line[line_offset] < 0) || (line[line_offset] > 127)) { line_offset++; }
+	// bypass lines containing only whitespaces
+	if (whitespaces_only(&line[line_offset]))
+		return PARSED_NONE;
 
+	// bypass comment lines
+	if ((line[line_offset] == '%') || (line[line_offset] == '*'))
+		return PARSED_NONE;
 
-		// bypass lines containing only whitespaces
-		if (whitespaces_only(&line[line_offset]))
-			continue;
 
-		// bypass comment lines
-		if ((line[line_offset] == '%') || (line[line_offset] == '*'))
-			continue;
+	/*#ifdef DEBUG*/
+	if (verbose)
+		printf(GRN "<line read> %s\n" NRM, &line[line_offset]);
+	/*#endif*/
 
 
-		/*#ifdef DEBUG*/
-		printf(GRN "<line read> %s" NRM, &line[line_offset]);
-		/*#endif*/
 
+	/* ************** *
+	 * PARSE THE LINE *
+	 * ************** */
 
+	/* re-initialise variables and parse line */
+	has_G2 = 0;
+	type = 'X';
+	name = NULL;
+	node1_name = NULL;
+	node2_name = NULL;
+	node3_name = NULL;
+	node4_name = NULL;
+	model_name = NULL;
+	tr_type = TR_TYPE_NONE;
+	tran_spec_data = NULL;
+	v1 = 0; v2 = 0; v3 = 0;
+	v4 = 0; v5 = 0; v6 = 0; v7 = 0;
+	times = NULL; values = NULL;
+	total_tuples = 0;
 
-		/* ************** *
-		 * PARSE THE LINE *
-		 * ************** */
+	// -1 if not present or part of the component parsed
+	val = -1;
+	l = -1;
+	w = -1;
 
-		/* re-initialise variables and parse line */
-		has_G2 = 0;
-		type = 'X';
-		name = NULL;
-		node1_name = NULL;
-		node2_name = NULL;
-		node3_name = NULL;
-		node4_name = NULL;
-		model_name = NULL;
-		tr_type = TR_TYPE_NONE;
-		tran_spec_data = NULL;
-		v1 = 0; v2 = 0; v3 = 0;
-		v4 = 0; v5 = 0; v6 = 0; v7 = 0;
-		times = NULL; values = NULL;
-		total_tuples = 0;
+	rest_line_commented = 0;
+	min_tok_count = 0;
+	tok_count = 0;
 
-		// -1 if not present or part of the component parsed
-		val = -1;
-		l = -1;
-		w = -1;
 
-		rest_line_commented = 0;
-		min_tok_count = 0;
-		tok_count = 0;
 
 
+	// check if the first line character is '.'
+	if (line[line_offset] == '.') {
+		P->command = &line[line_offset];
+		return PARSED_COMMAND; // nothing more for this line
+	}
 
 
-		// check if the first line character is '.'
-		if (line[line_offset] == '.') {
-			parse_command(&line[line_offset]);
-			continue; // nothing more for this line
-		}
+	// not a command. parse the component information
 
+	token = strtok_r(&line[line_offset], delim, &save_ptr);
 
-		// not a command. parse the component information
+	while (token != NULL) {
+		/*printf("token = %s\n", token);*/
+		// a comment might start with an '*' or a '%'
+		line_pos = strpbrk(token, "%*");
+		if (line_pos != NULL) {
+
+			// the line comment starts at the beggining of the token
+			if (*line_pos == token[0])
+				break;
 
-		token = strtok(&line[line_offset], delim);
+			// comment starts somewhere in the token
+			*line_pos = '\0';
+			rest_line_commented = 1;
+		}
 
-		while (token != NULL) {
-			/*printf("token = %s\n", token);*/
-			// a comment might start with an '*' or a '%'
-			line_pos = strpbrk(token, "%*");
-			if (line_pos != NULL) {
 
-				// the line comment starts at the beggining of the token
-				if (*line_pos == token[0])
-					break;
+		/* ************************ *
+		 * TOKEN PROCESSING SECTION *
+		 * ************************ */
 
-				// comment starts somewhere in the token
-				*line_pos = '\0';
-				rest_line_commented = 1;
-			}
+		tok_count++;
+		/*printf("Token #%u: %s\n", tok_count, token);*/
 
+		if (tok_count == 1) {
 
-			/* ************************ *
-			 * TOKEN PROCESSING SECTION *
-			 * ************************ */
+			type = token[0];
+			if (verbose)
+				printf("type = %c\n", type);
+			if (!component_type_is_valid(type)) {
+				PARSE_ERROR("Syntax Error: Invalid component type (%s)\n", token);
+				exit(EXIT_FAILURE);
+			}
+			name = &token[1];
 
-			tok_count++;
-			/*printf("Token #%u: %s\n", tok_count, token);*/
+			if (strchr("VIRCLD", toupper(type)) != NULL)
+				min_tok_count = 4;
+			else if (toupper(type) == 'Q')
+				min_tok_count = 5;
+			else // if (toupper(type) == 'M')
+				min_tok_count = 8;
 
-			if (tok_count == 1) {
+		}
+		else if (tok_count == 2) {
 
-				type = token[0];
-				printf("type = %c\n", type);
-				if (!component_type_is_valid(type)) {
-					printf("Syntax Error: Invalid component type (%s)\n", token);
-					exit(EXIT_FAILURE);
-				}
-				name = strdup(&token[1]);
-				if (name == NULL) {
-					printf("Error. Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
+			node1_name = token;
+		}
+		else if (tok_count == 3) {
 
-				if (strchr("VIRCLD", toupper(type)) != NULL)
-					min_tok_count = 4;
-				else if (toupper(type) == 'Q')
-					min_tok_count = 5;
-				else // if (toupper(type) == 'M')
-					min_tok_count = 8;
+			node2_name = token;
+		}
+		else if (tok_count == 4) {
 
+			if (toupper(type) == 'D') {
+				model_name = token;
 			}
-			else if (tok_count == 2) {
-
-				node1_name = strdup(token);
-				if (node1_name == NULL) {
-					printf("Error. Memory allocation problems. Exiting..\n");
+			else if ((toupper(type) == 'M') || (toupper(type) == 'Q')) {
+				node3_name = token;
+			}
+			else {	// V, I, R, C, L
+				if (parse_double(&val, token) == 0) {
+					PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 					exit(EXIT_FAILURE);
 				}
 			}
-			else if (tok_count == 3) {
+		}
+		else if (tok_count == 5) {
 
-				node2_name = strdup(token);
-				if (node2_name == NULL) {
-					printf("Error. Memory allocation problems. Exitin..\n");
+			if (((toupper(type) == 'I') || (toupper(type) == 'R') || (toupper(type) == 'C')) &&
+			   ((strcmp(token, "G2") == 0) || (strcmp(token, "g2") == 0))) {
+				has_G2 = 1;
+			}
+			else if ((toupper(type) == 'D')) {
+				if (parse_double(&val, token) == 0) {
+					PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 					exit(EXIT_FAILURE);
 				}
 			}
-			else if (tok_count == 4) {
+			else if ((toupper(type) == 'M')) {
+				node4_name = token;
+			}
+			else if ((toupper(type) == 'Q')) {
+				model_name = token;
+			}
+			else if ((toupper(type) == 'I') || (toupper(type) == 'V')) { // transient analysis
+
+			    /* ******************************* *
+				 * START OF TRANSIENT SPEC PARSING *
+				 * ******************************* */
+
+				if ((strncasecmp(token, "EXP", 3) == 0) \
+				 || (strncasecmp(token, "SIN", 3) == 0) \
+				 || (strncasecmp(token, "PWL", 3) == 0) \
+				 || (strncasecmp(token, "PULSE", 5) == 0)) {
+
+					if (verbose)
+						printf("Transient Spec Found\n");
+
+					// The second letter of the words EXP, SIN, PULSE and PWL is unique
+					// Take advantage of this for some easy and lazy checks
+					if (toupper(token[1] == 'W')) { // PWL
+						if (verbose)
+							printf("PWL function\n");
+						tr_type = TR_TYPE_PWL;
+
+
+						// check if there is no whitespace after the function name (PWL)
+						// (then the first tuple parentheses will be present in the same token)
+						flag = 1;
+						idx = 1;
+						if (strchr(token, '(') != NULL) {
+							idx = 4;
+							flag = 0;
+						}
+
+						// iterate through tuples
+						total_tuples = 0;
+						while (1) {
+
+							// read time
+							if (flag == 1) {
+								token = strtok_r(NULL, delim, &save_ptr);
+								// no more tuples
+								if (token == NULL)
+									break;
+							}
+
+							// temporarily store time into v1
+							if (parse_double_until(&v1, &token[idx], ',') == 0) {
+								PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
+								free(times);
+								free(values);
+								exit(EXIT_FAILURE);
+							}
+
+							if (flag == 0) {
+								flag = 1;
+								idx = 1;
+							}
+
+							// each time should be bigger than the previous one
+							if (total_tuples > 0) {
+								if (v1 <= times[total_tuples-1]) {
+									PARSE_ERROR("Error. Tuple time shouldn't be smaller "
+											"than previous time\n");
+									free(times);
+									free(values);
+									exit(EXIT_FAILURE);
+								}
+							}
+
+							// read value
+							token = strtok_r(NULL, delim, &save_ptr);
+							if (token == NULL) {
+								PARSE_ERROR("Error. Incomplete PWL tuple.\n");
+								free(times);
+								free(values);
+								exit(EXIT_FAILURE);
+							}
+
+
+							// check for ')'
+							if (strchr(token, ')') == NULL) {
+								PARSE_ERROR("Error. Parentheses must close directly after value (%s)\n",\
+								token);
+								free(times);
+								free(values);
+								exit(EXIT_FAILURE);
+							}
+
+							if (parse_double_until(&v2, token, ')') == 0) {
+								PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
+								free(times);
+								free(values);
+								exit(EXIT_FAILURE);
+							}
+
+
+							// store the (time value) tuple
+							total_tuples++;
+							times  = (double *) realloc(times, total_tuples*sizeof(double));
+							values = (double *) realloc(values, total_tuples*sizeof(double));
+							if ((times == NULL) || (values == NULL)) {
+								PARSE_ERROR("Error. Memory allocation problems. Exiting..\n");
+								exit(EXIT_FAILURE);
+							}
+
+							times[total_tuples-1] = v1;
+							values[total_tuples-1] = v2;
+
+						}
+
+						if (verbose) {
+							printf("tuples (%d): (times, values) = ", total_tuples);
+							for (i = 0; i < total_tuples; i++) {
+								printf("(%lf, %lf) ", times[i], values[i]);
+							}
+							printf("\n");
+						}
 
-				if (toupper(type) == 'D') {
-					model_name = strdup(token);
-					if (model_name == NULL) {
-						printf("Error. Memory allocation problems. Exiting..\n");
-						exit(EXIT_FAILURE);
-					}
-				}
-				else if ((toupper(type) == 'M') || (toupper(type) == 'Q')) {
-					node3_name = strdup(token);
-					if (node3_name == NULL) {
-						printf("Error. Memory allocation problems. Exiting..\n");
-						exit(EXIT_FAILURE);
-					}
-				}
-				else {	// V, I, R, C, L
-					if (parse_double(&val, token) == 0) {
-						printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-						exit(EXIT_FAILURE);
 					}
-				}
-			}
-			else if (tok_count == 5) {
+					else if (strchr("XIU", toupper(token[1])) != NULL) { // eXp sIn pUlse
+
+						if (toupper(token[1]) == 'X')
+							tr_type = TR_TYPE_EXP;
+						else if (toupper(token[1]) == 'I')
+							tr_type = TR_TYPE_SIN;
+						else
+							tr_type = TR_TYPE_PULSE;
+
+						// parse the fist argument (i1)
+						if (strncasecmp(token, "PULSE(", 6) == 0) {
+
+							if (parse_double_until(&v1, &token[6], ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converter to double\n", &token[6]);
+								exit(EXIT_FAILURE);
+							}
+						}
+						else if ((strncasecmp(token, "EXP(", 4) == 0) || (strncasecmp(token, "SIN(", 4) == 0)) { // exp or sin
+
+							if (parse_double_until(&v1, &token[4], ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", &token[3]);
+								exit(EXIT_FAILURE);
+							}
+						}
+						else {  // parentheses open after a whitespace following the function name
+
+							// parse i1
+							token = strtok_r(NULL, delim, &save_ptr);
+
+							if (parse_double_until(&v1, &token[1], ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
+								exit(EXIT_FAILURE);
+							}
+						}
+
+
+						// parse i2 (for exp and pulse) or ia (for sin)
+						token = strtok_r(NULL, delim, &save_ptr);
+
+						if (parse_double_until(&v2, token, ',') == 0) {
+							PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
+							exit(EXIT_FAILURE);
+						}
+
+
+						// parse td1 (exp) or fr (sin) or td (pulse)
+						token = strtok_r(NULL, delim, &save_ptr);
+
+						if (parse_double_until(&v3, token, ',') == 0) {
+							PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
+							exit(EXIT_FAILURE);
+						}
+
+
+
+						// parse tc1 (exp) or td (sin) or tr (pulse)
+						token = strtok_r(NULL, delim, &save_ptr);
+
+						if (parse_double_until(&v4, token, ',') == 0) {
+							PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
+							exit(EXIT_FAILURE);
+						}
+
+
+						// parse td2 (exp) or df (sin) or tf (pulse)
+						token = strtok_r(NULL, delim, &save_ptr);
+
+						if (parse_double_until(&v5, token, ',') == 0) {
+							PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
+							exit(EXIT_FAILURE);
+						}
+
+
+						// parse the last arguments
+						if (tr_type == TR_TYPE_EXP) {  // exp function
+							if (verbose)
+								printf("EXP function\n");
+
+							// parse tc2 (this is the 6th and last argument of exp function)
+							token = strtok_r(NULL, delim, &save_ptr);
+
+							// check for ')'
+							if (strchr(token, ')') == NULL) {
+								PARSE_ERROR("Error. Parenthesis must close directly after value (%s)\n",\
+								token);
+								exit(EXIT_FAILURE);
+							}
+
+							if (parse_double_until(&v6, token, ')') == 0) {
+								PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
+								exit(EXIT_FAILURE);
+							}
+
+
+							// check if there is another argument (syntax error)
+							token = strtok_r(NULL, delim, &save_ptr);
+							if (token != NULL) {
+								PARSE_ERROR("Error. Too many fields in transient function\n");
+								exit(EXIT_FAILURE);
+							}
+						}
+						else if (tr_type == TR_TYPE_SIN) {
+							if (verbose)
+								printf("SIN function\n");
+
+							// parse tc2 (this is the 6th and last argument of sin function)
+							token = strtok_r(NULL, delim, &save_ptr);
+
+							// check for ')'
+							if (strchr(token, ')') == NULL) {
+								PARSE_ERROR("Error. Parenthesis must close directly after value (%s)\n",\
+								token);
+								exit(EXIT_FAILURE);
+							}
+
+							if (parse_double_until(&v6, token, ')') == 0) {
+								PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
+								exit(EXIT_FAILURE);
+							}
+
+
+							// check if there is another argument (syntax error)
+							token = strtok_r(NULL, delim, &save_ptr);
+							if (token != NULL) {
+								PARSE_ERROR("Error. Too many fields in transient function\n");
+								exit(EXIT_FAILURE);
+							}
+
+						}
+						else  { // if (toupper(token[1]) == 'U')
+							if (verbose)
+								printf("PULSE function\n");
+
+							// parse pw (this is the 6th argument of pulse function)
+							token = strtok_r(NULL, delim, &save_ptr);
+
+							if (parse_double_until(&v6, token, ',') == 0) {
+								PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
+								exit(EXIT_FAILURE);
+							}
+
+
+							// parse per (this is the 7th and last argument of pulse function)
+							token = strtok_r(NULL, delim, &save_ptr);
+
+							// check for ')'
+							if (strchr(token, ')') == NULL) {
+								PARSE_ERROR("Error. Parenthesis must close directly after value (%s)\n",\
+								token);
+								exit(EXIT_FAILURE);
+							}
+
+							if (parse_double_until(&v7, token, ')') == 0) {
+								PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
+								exit(EXIT_FAILURE);
+							}
+
+
+							// check if there is another argument (syntax error)
+							token = strtok_r(NULL, delim, &save_ptr);
+							if (token != NULL) {
+								PARSE_ERROR("Error. Too many fields in transient function\n");
+								exit(EXIT_FAILURE);
+							}
+
+							// check if the period of the pulse if not big enough
+							// td + per must be bigger than td + tr + tf + pw
+							if ((v3 + v7) < (v3 + v4 + v5 + v6)) {
+								PARSE_ERROR(RED "Error: " NRM "Pulse period not big enough\n");
+								exit(EXIT_FAILURE);
+							}
+						}
+
+						// print the parsed arguments
+						if (verbose)
+							printf("arg1=%lf, arg2=%lf, arg3=%lf, arg4=%lf, "
+								   "arg5=%lf, arg6=%lf, arg7=%lf\n", \
+									v1, v2, v3, v4, v5, v6, v7);
 
-				if (((toupper(type) == 'I') || (toupper(type) == 'R') || (toupper(type) == 'C')) &&
-				   ((strcmp(token, "G2") == 0) || (strcmp(token, "g2") == 0))) {
-					has_G2 = 1;
-				}
-				else if ((toupper(type) == 'D')) {
-					if (parse_double(&val, token) == 0) {
-						printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-						exit(EXIT_FAILURE);
 					}
-				}
-				else if ((toupper(type) == 'M')) {
-					node4_name = strdup(token);
-					if (node4_name == NULL) {
-						printf("Error. Memory allocation problems. Exiting..\n");
+					else {
+						PARSE_ERROR("Error. Unknown transient function (%s)\n", token);
 						exit(EXIT_FAILURE);
 					}
+
+					break;
 				}
-				else if ((toupper(type) == 'Q')) {
-					model_name = strdup(token);
-					if (model_name == NULL) {
-						printf("Error. Memory allocation problems. Exiting..\n");
-						exit(EXIT_FAILURE);
-					}
+				else {
+					PARSE_ERROR("syntax error. Type '%c' has unknown fifth field (%s)\n", type, token);
+					exit(EXIT_FAILURE);
 				}
-				else if ((toupper(type) == 'I') || (toupper(type) == 'V')) { // transient analysis
 
-				    /* ******************************* *
-					 * START OF TRANSIENT SPEC PARSING *
-					 * ******************************* */
+				/* ***************************** *
+				 * END OF TRANSIENT SPEC PARSING *
+				 * ***************************** */
 
-					strcpy(tmp_str, token);
-					strtoupper(tmp_str);
+			}
+			else {
+				PARSE_ERROR("Syntax error. Type '%c' has unknown fifth field (%s)\n", type, token);
+				exit(EXIT_FAILURE);
+			}
 
-					if ((strncmp(tmp_str, "EXP", 3) == 0) \
-					 || (strncmp(tmp_str, "SIN", 3) == 0) \
-					 || (strncmp(tmp_str, "PWL", 3) == 0) \
-					 || (strncmp(tmp_str, "PULSE", 5) == 0)) {
+		}
+		else if (tok_count == 6) {
 
-						printf("Transient Spec Found\n");
+			if (toupper(type) == 'M') {
+				model_name = token;
+			}
+			else if (toupper(type) == 'Q') {
+				if (parse_double(&val, token) == 0) {
+					PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
+					exit(EXIT_FAILURE);
+				}
+			}
+			else if (toupper(type) == 'I') {  // transient analysis (I had G2 field)
+
+				/* ******************************* *
+				 * START OF TRANSIENT SPEC PARSING *
+				 * ******************************* */
+
+				// is G2 was found at 'I' component than transient spec might start
+				// at the sixth field/token instead of the fifth
+				if (has_G2 == 1) {
+					if ((strncasecmp(token, "EXP", 3) == 0) \
+					 || (strncasecmp(token, "SIN", 3) == 0) \
+					 || (strncasecmp(token, "PWL", 3) == 0) \
+					 || (strncasecmp(token, "PULSE", 5) == 0)) {
+						if (verbose)
+							printf("Transient Spec Found\n");
 
 						// The second letter of the words EXP, SIN, PULSE and PWL is unique
 						// Take advantage of this for some easy and lazy checks
 						if (toupper(token[1] == 'W')) { // PWL
-							printf("PWL function\n");
+							if (verbose)
+								printf("PWL function\n");
 							tr_type = TR_TYPE_PWL;
 
 
@@ -457,19 +731,16 @@ void parse_cir(char *filename) {
 
 								// read time
 								if (flag == 1) {
-									token = strtok(NULL, delim);
+									token = strtok_r(NULL, delim, &save_ptr);
 									// no more tuples
 									if (token == NULL)
 										break;
 								}
 
-								// temporarily store time into v1
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
 
-								if (parse_double(&v1, &tmp_str[idx]) == 0) {
-									printf("Error. Value (%s) cannot be converted to double\n", token);
+								// temporarily store time into v1
+								if (parse_double_until(&v1, &token[idx], ',') == 0) {
+									PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
 									free(times);
 									free(values);
 									exit(EXIT_FAILURE);
@@ -483,7 +754,7 @@ void parse_cir(char *filename) {
 								// each time should be bigger than the previous one
 								if (total_tuples > 0) {
 									if (v1 <= times[total_tuples-1]) {
-										printf("Error. Tuple time shouldn't be smaller "
+										PARSE_ERROR("Error. Tuple time shouldn't be smaller "
 												"than previous time\n");
 										free(times);
 										free(values);
@@ -492,9 +763,9 @@ void parse_cir(char *filename) {
 								}
 
 								// read value
-								token = strtok(NULL, delim);
+								token = strtok_r(NULL, delim, &save_ptr);
 								if (token == NULL) {
-									printf("Error. Incomplete PWL tuple.\n");
+									PARSE_ERROR("Error. Incomplete PWL tuple.\n");
 									free(times);
 									free(values);
 									exit(EXIT_FAILURE);
@@ -503,21 +774,19 @@ void parse_cir(char *filename) {
 
 								// check for ')'
 								if (strchr(token, ')') == NULL) {
-									printf("Error. Parentheses must close directly after value (%s)\n",\
+									PARSE_ERROR("Error. Parentheses must close directly after value (%s)\n",\
 									token);
 									free(times);
 									free(values);
 									exit(EXIT_FAILURE);
 								}
 
-								token[strlen(token)-1] = '\0';  // get rid of ')'
-								if (parse_double(&v2, token) == 0) {
-									printf("Error. Value (%s) cannot be converted to double\n", token);
+								if (parse_double_until(&v2, token, ')') == 0) {
+									PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
 									free(times);
 									free(values);
 									exit(EXIT_FAILURE);
 								}
-								token[strlen(token)] = ')';     // recover previously deleted ')'
 
 
 								// store the (time value) tuple
@@ -525,7 +794,7 @@ void parse_cir(char *filename) {
 								times  = (double *) realloc(times, total_tuples*sizeof(double));
 								values = (double *) realloc(values, total_tuples*sizeof(double));
 								if ((times == NULL) || (values == NULL)) {
-									printf("Error. Memory allocation problems. Exiting..\n");
+									PARSE_ERROR("Error. Memory allocation problems. Exiting..\n");
 									exit(EXIT_FAILURE);
 								}
 
@@ -534,11 +803,20 @@ void parse_cir(char *filename) {
 
 							}
 
-							printf("tuples (%d): (times, values) = ", total_tuples);
-							for (i = 0; i < total_tuples; i++) {
-								printf("(%lf, %lf) ", times[i], values[i]);
+
+							if (total_tuples == 0) {
+								PARSE_ERROR(RED "Error: " NRM "No tuples given in PWL\n");
+								exit(EXIT_FAILURE);
+							}
+
+
+							if (verbose) {
+								printf("tuples (%d): (times, values) = ", total_tuples);
+								for (i = 0; i < total_tuples; i++) {
+									printf("(%lf, %lf) ", times[i], values[i]);
+								}
+								printf("\n");
 							}
-							printf("\n");
 
 						}
 						else if (strchr("XIU", toupper(token[1])) != NULL) { // eXp sIn pUlse
@@ -551,943 +829,645 @@ void parse_cir(char *filename) {
 								tr_type = TR_TYPE_PULSE;
 
 							// parse the fist argument (i1)
-							strcpy(tmp_str, token);
-							strtoupper(tmp_str);
-							if (strncmp(tmp_str, "PULSE(", 6) == 0) {
+							if (strncasecmp(token, "PULSE(", 6) == 0) {
 
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
-
-								if (parse_double(&v1, &tmp_str[6]) == 0) {
-									printf("Syntax error. Value (%s) cannot be converter to double\n", &token[6]);
+								if (parse_double_until(&v1, &token[6], ',') == 0) {
+									PARSE_ERROR("Syntax error. Value (%s) cannot be converter to double\n", &token[6]);
 									exit(EXIT_FAILURE);
 								}
 							}
-							else if ((strncmp(tmp_str, "EXP(", 4) == 0) || (strncmp(tmp_str, "SIN(", 4) == 0)) { // exp or sin
-
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
+							else if ((strncasecmp(token, "EXP(", 4) == 0) || (strncasecmp(token, "SIN(", 4) == 0)) { // exp or sin
 
-								if (parse_double(&v1, &tmp_str[4]) == 0) {
-									printf("Syntax error. Value (%s) cannot be converted to double\n", &token[3]);
+								if (parse_double_until(&v1, &token[4], ',') == 0) {
+									PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", &token[3]);
 									exit(EXIT_FAILURE);
 								}
 							}
 							else {  // parentheses open after a whitespace following the function name
 
 								// parse i1
-								token = strtok(NULL, delim);
+								token = strtok_r(NULL, delim, &save_ptr);
 
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
-
-								if (parse_double(&v1, &tmp_str[1]) == 0) {
-									printf("Syntax error. Value (%s) cannot be converted to double\n", token);
+								if (parse_double_until(&v1, &token[1], ',') == 0) {
+									PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 									exit(EXIT_FAILURE);
 								}
 							}
 
 
 							// parse i2 (for exp and pulse) or ia (for sin)
-							token = strtok(NULL, delim);
-
-							strcpy(tmp_str, token);
-							if (strchr(tmp_str, ',') != NULL)
-								strchr(tmp_str, ',')[0] = '\0';
+							token = strtok_r(NULL, delim, &save_ptr);
 
-							if (parse_double(&v2, tmp_str) == 0) {
-								printf("Syntax error. Value (%s) cannot be converted to double\n", token);
+							if (parse_double_until(&v2, token, ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 								exit(EXIT_FAILURE);
 							}
 
 
 							// parse td1 (exp) or fr (sin) or td (pulse)
-							token = strtok(NULL, delim);
+							token = strtok_r(NULL, delim, &save_ptr);
 
-							strcpy(tmp_str, token);
-							if (strchr(tmp_str, ',') != NULL)
-								strchr(tmp_str, ',')[0] = '\0';
-
-							if (parse_double(&v3, tmp_str) == 0) {
-								printf("Syntax error. Value (%s) cannot be converted to double\n", token);
+							if (parse_double_until(&v3, token, ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 								exit(EXIT_FAILURE);
 							}
 
 
 
 							// parse tc1 (exp) or td (sin) or tr (pulse)
-							token = strtok(NULL, delim);
-
-							strcpy(tmp_str, token);
-							if (strchr(tmp_str, ',') != NULL)
-								strchr(tmp_str, ',')[0] = '\0';
+							token = strtok_r(NULL, delim, &save_ptr);
 
-							if (parse_double(&v4, tmp_str) == 0) {
-								printf("Syntax error. Value (%s) cannot be converted to double\n", token);
+							if (parse_double_until(&v4, token, ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 								exit(EXIT_FAILURE);
 							}
 
 
 							// parse td2 (exp) or df (sin) or tf (pulse)
-							token = strtok(NULL, delim);
+							token = strtok_r(NULL, delim, &save_ptr);
 
-							strcpy(tmp_str, token);
-							if (strchr(tmp_str, ',') != NULL)
-								strchr(tmp_str, ',')[0] = '\0';
-
-							if (parse_double(&v5, tmp_str) == 0) {
-								printf("Syntax error. Value (%s) cannot be converted to double\n", token);
+							if (parse_double_until(&v5, token, ',') == 0) {
+								PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 								exit(EXIT_FAILURE);
 							}
 
 
 							// parse the last arguments
 							if (tr_type == TR_TYPE_EXP) {  // exp function
-								printf("EXP function\n");
+								if (verbose)
+									printf("EXP function\n");
 
 								// parse tc2 (this is the 6th and last argument of exp function)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
+								token = strtok_r(NULL, delim, &save_ptr);
 
 								// check for ')'
-								if (strchr(tmp_str, ')') == NULL) {
-									printf("Error. Parenthesis must close directly after value (%s)\n",\
+								if (strchr(token, ')') == NULL) {
+									PARSE_ERROR("Error. Parenthesis must close directly after value (%s)\n",\
 									token);
 									exit(EXIT_FAILURE);
 								}
 
-								tmp_str[strlen(tmp_str)-1] = '\0'; // get rid of ')'
-								if (parse_double(&v6, tmp_str) == 0) {
-									printf("Error. Value (%s) cannot be converted to double\n", tmp_str);
+								if (parse_double_until(&v6, token, ')') == 0) {
+									PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
 									exit(EXIT_FAILURE);
 								}
 
 
 								// check if there is another argument (syntax error)
-								token = strtok(NULL, delim);
+								token = strtok_r(NULL, delim, &save_ptr);
 								if (token != NULL) {
-									printf("Error. Too many fields in transient function\n");
+									PARSE_ERROR("Error. Too many fields in transient function\n");
 									exit(EXIT_FAILURE);
 								}
 							}
 							else if (tr_type == TR_TYPE_SIN) {
-								printf("SIN function\n");
+								if (verbose)
+									printf("SIN function\n");
 
 								// parse tc2 (this is the 6th and last argument of sin function)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
+								token = strtok_r(NULL, delim, &save_ptr);
 
 								// check for ')'
-								if (strchr(tmp_str, ')') == NULL) {
-									printf("Error. Parenthesis must close directly after value (%s)\n",\
+								if (strchr(token, ')') == NULL) {
+									PARSE_ERROR("Error. Parenthesis must close directly after value (%s)\n",\
 									token);
 									exit(EXIT_FAILURE);
 								}
 
-								tmp_str[strlen(tmp_str)-1] = '\0'; // get rid of ')'
-								if (parse_double(&v6, tmp_str) == 0) {
-									printf("Error. Value (%s) cannot be converted to double\n", token);
+								if (parse_double_until(&v6, token, ')') == 0) {
+									PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
 									exit(EXIT_FAILURE);
 								}
 
 
 								// check if there is another argument (syntax error)
-								token = strtok(NULL, delim);
+								token = strtok_r(NULL, delim, &save_ptr);
 								if (token != NULL) {
-									printf("Error. Too many fields in transient function\n");
+									PARSE_ERROR("Error. Too many fields in transient function\n");
 									exit(EXIT_FAILURE);
 								}
 
 							}
 							else  { // if (toupper(token[1]) == 'U')
-								printf("PULSE function\n");
+								if (verbose)
+									printf("PULSE function\n");
 
 								// parse pw (this is the 6th argument of pulse function)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
+								token = strtok_r(NULL, delim, &save_ptr);
 
-								if (parse_double(&v6, tmp_str) == 0) {
-									printf("Error. Value (%s) cannot be converted to double\n", token);
+								if (parse_double_until(&v6, token, ',') == 0) {
+									PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
 									exit(EXIT_FAILURE);
 								}
 
 
 								// parse per (this is the 7th and last argument of pulse function)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
+								token = strtok_r(NULL, delim, &save_ptr);
 
 								// check for ')'
-								if (strchr(tmp_str, ')') == NULL) {
-									printf("Error. Parenthesis must close directly after value (%s)\n",\
+								if (strchr(token, ')') == NULL) {
+									PARSE_ERROR("Error. Parenthesis must close directly after value (%s)\n",\
 									token);
 									exit(EXIT_FAILURE);
 								}
 
-								tmp_str[strlen(tmp_str)-1] = '\0';	// get rid of ')'
-								if (parse_double(&v7, tmp_str) == 0) {
-									printf("Error. Value (%s) cannot be converted to double\n", token);
+								if (parse_double_until(&v7, token, ')') == 0) {
+									PARSE_ERROR("Error. Value (%s) cannot be converted to double\n", token);
 									exit(EXIT_FAILURE);
 								}
 
 
 								// check if there is another argument (syntax error)
-								token = strtok(NULL, delim);
+								token = strtok_r(NULL, delim, &save_ptr);
 								if (token != NULL) {
-									printf("Error. Too many fields in transient function\n");
+									PARSE_ERROR("Error. Too many fields in transient function\n");
 									exit(EXIT_FAILURE);
 								}
 
 								// check if the period of the pulse if not big enough
 								// td + per must be bigger than td + tr + tf + pw
 								if ((v3 + v7) < (v3 + v4 + v5 + v6)) {
-									printf(RED "Error: " NRM "Pulse period not big enough\n");
+									PARSE_ERROR(RED "Error: " NRM "Pulse period not big enough\n");
 									exit(EXIT_FAILURE);
 								}
 							}
 
 							// print the parsed arguments
-							printf("arg1=%lf, arg2=%lf, arg3=%lf, arg4=%lf, "
-								   "arg5=%lf, arg6=%lf, arg7=%lf\n", \
-									v1, v2, v3, v4, v5, v6, v7);
+							if (verbose)
+								printf("arg1=%lf, arg2=%lf, arg3=%lf, arg4=%lf, "
+									   "arg5=%lf, arg6=%lf, arg7=%lf\n", \
+										v1, v2, v3, v4, v5, v6, v7);
+
 
 						}
 						else {
-							printf("Error. Unknown transient function (%s)\n", token);
+							PARSE_ERROR("Error. Unknown transient function (%s)\n", token);
 							exit(EXIT_FAILURE);
 						}
 
 						break;
 					}
 					else {
-						printf("syntax error. Type '%c' has unknown fifth field (%s)\n", type, token);
+						PARSE_ERROR("syntax error. Type '%c' has unknown sixth field (%s)\n", type, token);
 						exit(EXIT_FAILURE);
 					}
-
-					/* ***************************** *
-					 * END OF TRANSIENT SPEC PARSING *
-					 * ***************************** */
-
 				}
 				else {
-					printf("Syntax error. Type '%c' has unknown fifth field (%s)\n", type, token);
+					PARSE_ERROR("Syntax error. Type %c has unknown sixth field (%s)\n", type, token);
 					exit(EXIT_FAILURE);
 				}
 
+				/* ***************************** *
+				 * END OF TRANSIENT SPEC PARSING *
+				 * ***************************** */
+
+			}
+			else {
+				PARSE_ERROR("Syntax error. Type '%c' cannot have a 6th field\n", type);
+				exit(EXIT_FAILURE);
 			}
-			else if (tok_count == 6) {
 
-				if (toupper(type) == 'M') {
-					model_name = strdup(token);
-					if (model_name == NULL) {
-						printf("Error. Memory allocation problems. Exiting..\n");
+		}
+		else if (tok_count == 7) {
+			if (toupper(type) == 'M') {
+				if ((toupper(token[0]) != 'L') && (token[1] != '=')) {
+					PARSE_ERROR("Syntax error: Invalid field value (%s)\n", token);
+					exit(EXIT_FAILURE);
+				}
+				else {
+					if (parse_double(&l, &token[2]) == 0) {
+						PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 						exit(EXIT_FAILURE);
 					}
 				}
-				else if (toupper(type) == 'Q') {
-					if (parse_double(&val, token) == 0) {
-						printf("Syntax error. Value (%s) cannot be converted to double\n", token);
+			}
+			else {
+				PARSE_ERROR("Syntax error. Type '%c' doesn't have a 7th field\n", type);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (tok_count == 8) {
+			if (toupper(type) == 'M') {
+				if ((toupper(token[0]) != 'W') && (token[1] != '=')) {
+					PARSE_ERROR("Syntax error: Invalid field value (%s)\n", token);
+					exit(EXIT_FAILURE);
+				}
+				else {
+					if (parse_double(&w, &token[2]) == 0) {
+						PARSE_ERROR("Syntax error. Value (%s) cannot be converted to double\n", token);
 						exit(EXIT_FAILURE);
 					}
 				}
-				else if (toupper(type) == 'I') {  // transient analysis (I had G2 field)
-
-					/* ******************************* *
-					 * START OF TRANSIENT SPEC PARSING *
-					 * ******************************* */
-
-					// is G2 was found at 'I' component than transient spec might start
-					// at the sixth field/token instead of the fifth
-					if (has_G2 == 1) {
-						if ((strncmp(tmp_str, "EXP", 3) == 0) \
-						 || (strncmp(tmp_str, "SIN", 3) == 0) \
-						 || (strncmp(tmp_str, "PWL", 3) == 0) \
-						 || (strncmp(tmp_str, "PULSE", 5) == 0)) {
-							printf("Transient Spec Found\n");
-
-							// The second letter of the words EXP, SIN, PULSE and PWL is unique
-							// Take advantage of this for some easy and lazy checks
-							if (toupper(token[1] == 'W')) { // PWL
-								printf("PWL function\n");
-								tr_type = TR_TYPE_PWL;
-
-
-								// check if there is no whitespace after the function name (PWL)
-								// (then the first tuple parentheses will be present in the same token)
-								flag = 1;
-								idx = 1;
-								if (strchr(token, '(') != NULL) {
-									idx = 4;
-									flag = 0;
-								}
-
-								// iterate through tuples
-								total_tuples = 0;
-								while (1) {
-
-									// read time
-									if (flag == 1) {
-										token = strtok(NULL, delim);
-										// no more tuples
-										if (token == NULL)
-											break;
-									}
-
-
-									// temporarily store time into v1
-									if (parse_double(&v1, &token[idx]) == 0) {
-										printf("Error. Value (%s) cannot be converted to double\n", token);
-										free(times);
-										free(values);
-										exit(EXIT_FAILURE);
-									}
-
-									if (flag == 0) {
-										flag = 1;
-										idx = 1;
-									}
-
-									// each time should be bigger than the previous one
-									if (total_tuples > 0) {
-										if (v1 <= times[total_tuples-1]) {
-											printf("Error. Tuple time shouldn't be smaller "
-													"than previous time\n");
-											free(times);
-											free(values);
-											exit(EXIT_FAILURE);
-										}
-									}
-
-									// read value
-									token = strtok(NULL, delim);
-									if (token == NULL) {
-										printf("Error. Incomplete PWL tuple.\n");
-										free(times);
-										free(values);
-										exit(EXIT_FAILURE);
-									}
-
-
-									// check for ')'
-									if (strchr(token, ')') == NULL) {
-										printf("Error. Parentheses must close directly after value (%s)\n",\
-										token);
-										free(times);
-										free(values);
-										exit(EXIT_FAILURE);
-									}
-
-									token[strlen(token)-1] = '\0';  // get rid of ')'
-									if (parse_double(&v2, token) == 0) {
-										printf("Error. Value (%s) cannot be converted to double\n", token);
-										free(times);
-										free(values);
-										exit(EXIT_FAILURE);
-									}
-									token[strlen(token)] = ')';     // recover previously deleted ')'
-
-
-									// store the (time value) tuple
-									total_tuples++;
-									times  = (double *) realloc(times, total_tuples*sizeof(double));
-									values = (double *) realloc(values, total_tuples*sizeof(double));
-									if ((times == NULL) || (values == NULL)) {
-										printf("Error. Memory allocation problems. Exiting..\n");
-										exit(EXIT_FAILURE);
-									}
-
-									times[total_tuples-1] = v1;
-									values[total_tuples-1] = v2;
-
-								}
-
-
-								if (total_tuples == 0) {
-									printf(RED "Error: " NRM "No tuples given in PWL\n");
-									exit(EXIT_FAILURE);
-								}
-
-
-								printf("tuples (%d): (times, values) = ", total_tuples);
-								for (i = 0; i < total_tuples; i++) {
-									printf("(%lf, %lf) ", times[i], values[i]);
-								}
-								printf("\n");
-
-							}
-							else if (strchr("XIU", toupper(token[1])) != NULL) { // eXp sIn pUlse
-
-								if (toupper(token[1]) == 'X')
-									tr_type = TR_TYPE_EXP;
-								else if (toupper(token[1]) == 'I')
-									tr_type = TR_TYPE_SIN;
-								else
-									tr_type = TR_TYPE_PULSE;
-
-								// parse the fist argument (i1)
-								strcpy(tmp_str, token);
-								strtoupper(tmp_str);
-								if (strncmp(tmp_str, "PULSE(", 6) == 0) {
-
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
-
-									if (parse_double(&v1, &tmp_str[6]) == 0) {
-										printf("Syntax error. Value (%s) cannot be converter to double\n", &token[6]);
-										exit(EXIT_FAILURE);
-									}
-								}
-								else if ((strncmp(tmp_str, "EXP(", 4) == 0) || (strncmp(tmp_str, "SIN(", 4) == 0)) { // exp or sin
-
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
-
-									if (parse_double(&v1, &tmp_str[4]) == 0) {
-										printf("Syntax error. Value (%s) cannot be converted to double\n", &token[3]);
-										exit(EXIT_FAILURE);
-									}
-								}
-								else {  // parentheses open after a whitespace following the function name
-
-									// parse i1
-									token = strtok(NULL, delim);
-
-									strcpy(tmp_str, token);
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
-
-									if (parse_double(&v1, &tmp_str[1]) == 0) {
-										printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-										exit(EXIT_FAILURE);
-									}
-								}
-
-
-								// parse i2 (for exp and pulse) or ia (for sin)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
-
-								if (parse_double(&v2, tmp_str) == 0) {
-									printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-									exit(EXIT_FAILURE);
-								}
-
-
-								// parse td1 (exp) or fr (sin) or td (pulse)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
-
-								if (parse_double(&v3, tmp_str) == 0) {
-									printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-									exit(EXIT_FAILURE);
-								}
-
-
-
-								// parse tc1 (exp) or td (sin) or tr (pulse)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
-
-								if (parse_double(&v4, tmp_str) == 0) {
-									printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-									exit(EXIT_FAILURE);
-								}
-
-
-								// parse td2 (exp) or df (sin) or tf (pulse)
-								token = strtok(NULL, delim);
-
-								strcpy(tmp_str, token);
-								if (strchr(tmp_str, ',') != NULL)
-									strchr(tmp_str, ',')[0] = '\0';
-
-								if (parse_double(&v5, tmp_str) == 0) {
-									printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-									exit(EXIT_FAILURE);
-								}
-
-
-								// parse the last arguments
-								if (tr_type == TR_TYPE_EXP) {  // exp function
-									printf("EXP function\n");
-
-									// parse tc2 (this is the 6th and last argument of exp function)
-									token = strtok(NULL, delim);
-
-									strcpy(tmp_str, token);
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
-
-									// check for ')'
-									if (strchr(tmp_str, ')') == NULL) {
-										printf("Error. Parenthesis must close directly after value (%s)\n",\
-										token);
-										exit(EXIT_FAILURE);
-									}
-
-									tmp_str[strlen(tmp_str)-1] = '\0'; // get rid of ')'
-									if (parse_double(&v6, tmp_str) == 0) {
-										printf("Error. Value (%s) cannot be converted to double\n", tmp_str);
-										exit(EXIT_FAILURE);
-									}
-
-
-									// check if there is another argument (syntax error)
-									token = strtok(NULL, delim);
-									if (token != NULL) {
-										printf("Error. Too many fields in transient function\n");
-										exit(EXIT_FAILURE);
-									}
-								}
-								else if (tr_type == TR_TYPE_SIN) {
-									printf("SIN function\n");
-
-									// parse tc2 (this is the 6th and last argument of sin function)
-									token = strtok(NULL, delim);
-
-									strcpy(tmp_str, token);
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
-
-									// check for ')'
-									if (strchr(tmp_str, ')') == NULL) {
-										printf("Error. Parenthesis must close directly after value (%s)\n",\
-										token);
-										exit(EXIT_FAILURE);
-									}
+			}
+			else {
+				PARSE_ERROR("Syntax error. Type '%c' doesn't have a 8th field\n", type);
+				exit(EXIT_FAILURE);
+			}
+		}
 
-									tmp_str[strlen(tmp_str)-1] = '\0'; // get rid of ')'
-									if (parse_double(&v6, tmp_str) == 0) {
-										printf("Error. Value (%s) cannot be converted to double\n", token);
-										exit(EXIT_FAILURE);
-									}
 
+		// token contains start of comment line. continue parsing next line
+		if (rest_line_commented)
+			break;
 
-									// check if there is another argument (syntax error)
-									token = strtok(NULL, delim);
-									if (token != NULL) {
-										printf("Error. Too many fields in transient function\n");
-										exit(EXIT_FAILURE);
-									}
 
-								}
-								else  { // if (toupper(token[1]) == 'U')
-									printf("PULSE function\n");
+		token = strtok_r(NULL, delim, &save_ptr);
+	}
 
-									// parse pw (this is the 6th argument of pulse function)
-									token = strtok(NULL, delim);
+	// check if all the necessary fields were parsed
+	if (tok_count < min_tok_count) {
+		PARSE_ERROR("Syntax error. Missing field\n");
+		exit(EXIT_FAILURE);
+	}
 
-									strcpy(tmp_str, token);
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
+	if (verbose)
+		print_parsed_information(type, name, node1_name, node2_name, node3_name, \
+								 node4_name, val, has_G2, model_name, l, w);
 
-									if (parse_double(&v6, tmp_str) == 0) {
-										printf("Error. Value (%s) cannot be converted to double\n", token);
-										exit(EXIT_FAILURE);
-									}
 
+	// Search for node and if it doesn't exist add it to the hash table and
+	// give assign: node->id = ++id;
+
+	// V<name> <node1_name> <node2_name> <val> [transient_spec]
+	// I<name> <node1_name> <node2_name> <val> [G2] [transient_spec]
+	// R<name> <node1_name> <node2_name> <val> [G2]
+	// C<name> <node1_name> <node2_name> <val> [G2]
+	// L<name> <node1_name> <node2_name> <val>
+	// D<name> <node1_name> <node2_name> <model_name> [<val>]
+	// M<name> <node1_name> <node2_name> <node3_name> <node4_name> <model_name> L=<val> W=<val>
+	// Q<name> <node1_name> <node2_name> <node3_name> <model_name> [<val>]
+
+
+
+	// Create structures for transient analysis info
+	// Note: update the free functions of the lists and delete the frees below (done)
+	/*free(times);*/
+	/*free(values);*/
+	switch (tr_type) {
+		case TR_TYPE_NONE:
+			tran_spec_data = NULL;
+			break;
+		case TR_TYPE_EXP:
+			tran_spec_data = (void *) malloc(sizeof(ExpInfoT));
+			if (tran_spec_data == NULL) {
+				PARSE_ERROR("Error Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
-									// parse per (this is the 7th and last argument of pulse function)
-									token = strtok(NULL, delim);
+			((ExpInfoT *)tran_spec_data)->i1 = v1;
+			((ExpInfoT *)tran_spec_data)->i2 = v2;
+			((ExpInfoT *)tran_spec_data)->td1 = v3;
+			((ExpInfoT *)tran_spec_data)->tc1 = v4;
+			((ExpInfoT *)tran_spec_data)->td2 = v5;
+			((ExpInfoT *)tran_spec_data)->tc2 = v6;
+
+			break;
+		case TR_TYPE_SIN:
+			tran_spec_data = (void *) malloc(sizeof(SinInfoT));
+			if (tran_spec_data == NULL) {
+				PARSE_ERROR("Error Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
-									strcpy(tmp_str, token);
-									if (strchr(tmp_str, ',') != NULL)
-										strchr(tmp_str, ',')[0] = '\0';
+			((SinInfoT *)tran_spec_data)->i1 = v1;
+			((SinInfoT *)tran_spec_data)->ia = v2;
+			((SinInfoT *)tran_spec_data)->fr = v3;
+			((SinInfoT *)tran_spec_data)->td = v4;
+			((SinInfoT *)tran_spec_data)->df = v5;
+			((SinInfoT *)tran_spec_data)->ph = v6;
+
+			break;
+		case TR_TYPE_PULSE:
+			tran_spec_data = (void *) malloc(sizeof(PulseInfoT));
+			if (tran_spec_data == NULL) {
+				PARSE_ERROR("Error Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
-									// check for ')'
-									if (strchr(tmp_str, ')') == NULL) {
-										printf("Error. Parenthesis must close directly after value (%s)\n",\
-										token);
-										exit(EXIT_FAILURE);
-									}
+			((PulseInfoT *)tran_spec_data)->i1 = v1;
+			((PulseInfoT *)tran_spec_data)->i2 = v2;
+			((PulseInfoT *)tran_spec_data)->td = v3;
+			((PulseInfoT *)tran_spec_data)->tr = v4;
+			((PulseInfoT *)tran_spec_data)->tf = v5;
+			((PulseInfoT *)tran_spec_data)->pw = v6;
+			((PulseInfoT *)tran_spec_data)->per = v7;
+
+			break;
+		case TR_TYPE_PWL:
+			tran_spec_data = (void *) malloc(sizeof(PwlInfoT));
+			if (tran_spec_data == NULL) {
+				PARSE_ERROR("Error Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
-									tmp_str[strlen(tmp_str)-1] = '\0';	// get rid of ')'
-									if (parse_double(&v7, tmp_str) == 0) {
-										printf("Error. Value (%s) cannot be converted to double\n", token);
-										exit(EXIT_FAILURE);
-									}
+			((PwlInfoT *)tran_spec_data)->times = times;
+			((PwlInfoT *)tran_spec_data)->values = values;
+			((PwlInfoT *)tran_spec_data)->total_tuples = total_tuples;
 
+			break;
+		default:
+			PARSE_ERROR("Error. Unknown transient spec function. Exiting..\n");
+			exit(EXIT_FAILURE);
+	}
 
-									// check if there is another argument (syntax error)
-									token = strtok(NULL, delim);
-									if (token != NULL) {
-										printf("Error. Too many fields in transient function\n");
-										exit(EXIT_FAILURE);
-									}
 
-									// check if the period of the pulse if not big enough
-									// td + per must be bigger than td + tr + tf + pw
-									if ((v3 + v7) < (v3 + v4 + v5 + v6)) {
-										printf(RED "Error: " NRM "Pulse period not big enough\n");
-										exit(EXIT_FAILURE);
-									}
-								}
+	P->type = type;
+	P->name = name;
+	P->node1_name = node1_name;
+	P->node2_name = node2_name;
+	P->node3_name = node3_name;
+	P->node4_name = node4_name;
+	P->model_name = model_name;
+	P->val = val;
+	P->l = l;
+	P->w = w;
+	P->has_G2 = has_G2;
+	P->tr_type = tr_type;
+	P->tran_spec_data = tran_spec_data;
+	P->command = NULL;
+
+	return PARSED_COMPONENT;
+}
 
-								// print the parsed arguments
-								printf("arg1=%lf, arg2=%lf, arg3=%lf, arg4=%lf, "
-									   "arg5=%lf, arg6=%lf, arg7=%lf\n", \
-										v1, v2, v3, v4, v5, v6, v7);
 
+// stores a parsed component: adds its new nodes to the node table, numbered
+// in the order they appear (id holds the last id given), and the component to its list
+void store_parsed_line(parsed_line *P, unsigned long *id) {
+
+	byte has_G2 = P->has_G2;
+	char type = P->type;
+	char *name = P->name;
+	char *node1_name = P->node1_name;
+	char *node2_name = P->node2_name;
+	char *node3_name = P->node3_name;
+	char *node4_name = P->node4_name;
+	char *model_name = P->model_name;
+	double val = P->val;
+	double l = P->l;
+	double w = P->w;
+	int tr_type = P->tr_type;
+	void *tran_spec_data = P->tran_spec_data;
 
-							}
-							else {
-								printf("Error. Unknown transient function (%s)\n", token);
-								exit(EXIT_FAILURE);
-							}
+	element_h *node1 = NULL;
+	element_h *node2 = NULL;
+	element_h *node3 = NULL;
+	element_h *node4 = NULL;
 
-							break;
-						}
-						else {
-							printf("syntax error. Type '%c' has unknown sixth field (%s)\n", type, token);
-							exit(EXIT_FAILURE);
-						}
-					}
-					else {
-						printf("Syntax error. Type %c has unknown sixth field (%s)\n", type, token);
-						exit(EXIT_FAILURE);
-					}
+	switch (toupper(type)) {
+		case 'I':
+		case 'R':
+		case 'C':
+			node1 = ht_get_or_put(node1_name, id);
 
-					/* ***************************** *
-					 * END OF TRANSIENT SPEC PARSING *
-					 * ***************************** */
 
-				}
-				else {
-					printf("Syntax error. Type '%c' cannot have a 6th field\n", type);
-					exit(EXIT_FAILURE);
-				}
+			node2 = ht_get_or_put(node2_name, id);
 
-			}
-			else if (tok_count == 7) {
-				if (toupper(type) == 'M') {
-					if ((toupper(token[0]) != 'L') && (token[1] != '=')) {
-						printf("Syntax error: Invalid field value (%s)\n", token);
-						exit(EXIT_FAILURE);
-					}
-					else {
-						if (parse_double(&l, &token[2]) == 0) {
-							printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-							exit(EXIT_FAILURE);
-						}
-					}
-				}
-				else {
-					printf("Syntax error. Type '%c' doesn't have a 7th field\n", type);
+			// add component to node component list (hashtable field)
+			// update components list (lists)
+			if (has_G2 == 0){
+				if (insert_element(&team1_list, (toupper(type)=='I'?I:(toupper(type)=='R'?R:C)), \
+									name, node1, node2, val, tr_type, tran_spec_data) == -1) {
+					printf("insert_element. Memory allocation problems. Exiting..\n");
 					exit(EXIT_FAILURE);
 				}
-			}
-			else if (tok_count == 8) {
-				if (toupper(type) == 'M') {
-					if ((toupper(token[0]) != 'W') && (token[1] != '=')) {
-						printf("Syntax error: Invalid field value (%s)\n", token);
-						exit(EXIT_FAILURE);
-					}
-					else {
-						if (parse_double(&w, &token[2]) == 0) {
-							printf("Syntax error. Value (%s) cannot be converted to double\n", token);
-							exit(EXIT_FAILURE);
-						}
-					}
-				}
-				else {
-					printf("Syntax error. Type '%c' doesn't have a 8th field\n", type);
+			} else {
+				if (insert_element(&team2_list, (toupper(type)=='I'?I:(toupper(type)=='R'?R:C)), \
+									name, node1, node2, val, tr_type, tran_spec_data) == -1) {
+					printf("insert_element. Memory allocation problems. Exiting..\n");
 					exit(EXIT_FAILURE);
 				}
 			}
 
+			break;
 
-			// token contains start of comment line. continue parsing next line
-			if (rest_line_commented)
-				break;
+		case 'V':
+		case 'L':
 
+			node1 = ht_get_or_put(node1_name, id);
 
-			token = strtok(NULL, delim);
-		}
 
-		// check if all the necessary fields were parsed
-		if (tok_count < min_tok_count) {
-			printf("Syntax error. Missing field\n");
-			exit(EXIT_FAILURE);
-		}
+			node2 = ht_get_or_put(node2_name, id);
 
-		print_parsed_information(type, name, node1_name, node2_name, node3_name, \
-								 node4_name, val, has_G2, model_name, l, w);
+			// add component to node component list (hashtable field)
+			// update components list (lists)
+			if (insert_element(&team2_list, (toupper(type)=='V'?V:L), name, node1, node2, val, \
+						       tr_type, tran_spec_data) == -1) {
+				printf("insert_element. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
+			break;
+		case 'D':
 
-		// Search for node and if it doesn't exist add it to the hash table and
-		// give assign: node->id = ++id;
+			node1 = ht_get_or_put(node1_name, id);
 
-		// V<name> <node1_name> <node2_name> <val> [transient_spec]
-		// I<name> <node1_name> <node2_name> <val> [G2] [transient_spec]
-		// R<name> <node1_name> <node2_name> <val> [G2]
-		// C<name> <node1_name> <node2_name> <val> [G2]
-		// L<name> <node1_name> <node2_name> <val>
-		// D<name> <node1_name> <node2_name> <model_name> [<val>]
-		// M<name> <node1_name> <node2_name> <node3_name> <node4_name> <model_name> L=<val> W=<val>
-		// Q<name> <node1_name> <node2_name> <node3_name> <model_name> [<val>]
 
+			node2 = ht_get_or_put(node2_name, id);
 
+			if (insert_diode(name, node1, node2, model_name) == -1){
+				printf("insert_element. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
-		// Create structures for transient analysis info
-		// Note: update the free functions of the lists and delete the frees below (done)
-		/*free(times);*/
-		/*free(values);*/
-		switch (tr_type) {
-			case TR_TYPE_NONE:
-				tran_spec_data = NULL;
-				break;
-			case TR_TYPE_EXP:
-				tran_spec_data = (void *) malloc(sizeof(ExpInfoT));
-				if (tran_spec_data == NULL) {
-					printf("Error Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
+			break;
+		case 'M':
 
-				((ExpInfoT *)tran_spec_data)->i1 = v1;
-				((ExpInfoT *)tran_spec_data)->i2 = v2;
-				((ExpInfoT *)tran_spec_data)->td1 = v3;
-				((ExpInfoT *)tran_spec_data)->tc1 = v4;
-				((ExpInfoT *)tran_spec_data)->td2 = v5;
-				((ExpInfoT *)tran_spec_data)->tc2 = v6;
+			node1 = ht_get_or_put(node1_name, id);
 
-				break;
-			case TR_TYPE_SIN:
-				tran_spec_data = (void *) malloc(sizeof(SinInfoT));
-				if (tran_spec_data == NULL) {
-					printf("Error Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
 
-				((SinInfoT *)tran_spec_data)->i1 = v1;
-				((SinInfoT *)tran_spec_data)->ia = v2;
-				((SinInfoT *)tran_spec_data)->fr = v3;
-				((SinInfoT *)tran_spec_data)->td = v4;
-				((SinInfoT *)tran_spec_data)->df = v5;
-				((SinInfoT *)tran_spec_data)->ph = v6;
+			node2 = ht_get_or_put(node2_name, id);
 
-				break;
-			case TR_TYPE_PULSE:
-				tran_spec_data = (void *) malloc(sizeof(PulseInfoT));
-				if (tran_spec_data == NULL) {
-					printf("Error Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
 
-				((PulseInfoT *)tran_spec_data)->i1 = v1;
-				((PulseInfoT *)tran_spec_data)->i2 = v2;
-				((PulseInfoT *)tran_spec_data)->td = v3;
-				((PulseInfoT *)tran_spec_data)->tr = v4;
-				((PulseInfoT *)tran_spec_data)->tf = v5;
-				((PulseInfoT *)tran_spec_data)->pw = v6;
-				((PulseInfoT *)tran_spec_data)->per = v7;
+			node3 = ht_get_or_put(node3_name, id);
 
-				break;
-			case TR_TYPE_PWL:
-				tran_spec_data = (void *) malloc(sizeof(PwlInfoT));
-				if (tran_spec_data == NULL) {
-					printf("Error Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
 
-				((PwlInfoT *)tran_spec_data)->times = times;
-				((PwlInfoT *)tran_spec_data)->values = values;
-				((PwlInfoT *)tran_spec_data)->total_tuples = total_tuples;
+			node4 = ht_get_or_put(node4_name, id);
 
-				break;
-			default:
-				printf("Error. Unknown transient spec function. Exiting..\n");
+			if (insert_mos(name, node1, node2, node3, node4, l, w, model_name) == -1){
+				printf("insert_element. Memory allocation problems. Exiting..\n");
 				exit(EXIT_FAILURE);
-		}
+			}
 
 
+			break;
+		case 'Q':
 
-		switch (toupper(type)) {
-			case 'I':
-			case 'R':
-			case 'C':
-				node1 = ht_get(node1_name);
-				if (node1 == NULL) {
-					id++;
-					node1 = ht_put(node1_name, id);
-				}
+			node1 = ht_get_or_put(node1_name, id);
 
 
-				node2 = ht_get(node2_name);
-				if (node2 == NULL) {
-					id++;
-					node2 = ht_put(node2_name, id);
-				}
+			node2 = ht_get_or_put(node2_name, id);
 
-				// add component to node component list (hashtable field)
-				// update components list (lists)
-				if (has_G2 == 0){
-					if (insert_element(&team1_list, (toupper(type)=='I'?I:(toupper(type)=='R'?R:C)), \
-										name, node1, node2, val, tr_type, tran_spec_data) == -1) {
-						printf("insert_element. Memory allocation problems. Exiting..\n");
-						exit(EXIT_FAILURE);
-					}
-				} else {
-					if (insert_element(&team2_list, (toupper(type)=='I'?I:(toupper(type)=='R'?R:C)), \
-										name, node1, node2, val, tr_type, tran_spec_data) == -1) {
-						printf("insert_element. Memory allocation problems. Exiting..\n");
-						exit(EXIT_FAILURE);
-					}
-				}
-
-				break;
-
-			case 'V':
-			case 'L':
-
-				node1 = ht_get(node1_name);
-				if (node1 == NULL) {
-					id++;
-					node1 = ht_put(node1_name, id);
-				}
 
+			node3 = ht_get_or_put(node3_name, id);
 
-				node2 = ht_get(node2_name);
-				if (node2 == NULL) {
-					id++;
-					node2 = ht_put(node2_name, id);
-				}
+			if (insert_bjt(name, node1, node2, node3, model_name) == -1){
+				printf("insert_element. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 
-				// add component to node component list (hashtable field)
-				// update components list (lists)
-				if (insert_element(&team2_list, (toupper(type)=='V'?V:L), name, node1, node2, val, \
-							       tr_type, tran_spec_data) == -1) {
-					printf("insert_element. Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
+			break;
+		default :
+			printf("Unknown type (%c)\n", toupper(type));
+			exit(EXIT_FAILURE);
+	}
+}
 
-				break;
-			case 'D':
 
-				node1 = ht_get(node1_name);
-				if (node1 == NULL) {
-					id++;
-					node1 = ht_put(node1_name, id);
-				}
+// parse the Circuit file
+unsigned long parse_cir(char *filename) {
 
+	tok_file *F = NULL;
+	unsigned long components_num = 0;
+	unsigned long id = 0;
+	char *line = NULL;		// the line parsed
+	parsed_line P;
+	int threads = 1;
+
+	// the names of the components and nodes point into the mapped file,
+	// they are copied only when they are stored
+	F = tok_open(filename);
+
+#ifdef _OPENMP
+	threads = omp_get_max_threads();
+#endif
+	if ((threads > 1) && (F->size >= PARSE_PAR_MIN_SIZE)) {
+		components_num = parse_cir_parallel(F, threads);
+		tok_close(F);
+		return components_num;
+	}
 
-				node2 = ht_get(node2_name);
-				if (node2 == NULL) {
-					id++;
-					node2 = ht_put(node2_name, id);
-				}
 
-				if (insert_diode(name, node1, node2, model_name) == -1){
-					printf("insert_element. Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
+	// read the file line-by-line
+	while((line = tok_next_line(F)) != NULL) {
 
+		switch (parse_line(line, &P, 1, NULL)) {
+			case PARSED_COMMAND:
+				if (nc_recording)
+					nc_record_command(P.command);
+				parse_command(P.command);
 				break;
-			case 'M':
-
-				node1 = ht_get(node1_name);
-				if (node1 == NULL) {
-					id++;
-					node1 = ht_put(node1_name, id);
-				}
-
-
-				node2 = ht_get(node2_name);
-				if (node2 == NULL) {
-					id++;
-					node2 = ht_put(node2_name, id);
-				}
-
+			case PARSED_COMPONENT:
+				store_parsed_line(&P, &id);
+				components_num++;
 
-				node3 = ht_get(node3_name);
-				if (node3 == NULL) {
-					id++;
-					node3 = ht_put(node3_name, id);
-				}
+				printf("\n");
+				/*printf("parsed %s\n", token);*/
+				break;
+		}
+	}
 
+	tok_close(F);
+	return components_num;
+}
 
-				node4 = ht_get(node4_name);
-				if (node4 == NULL) {
-					id++;
-					node4 = ht_put(node4_name, id);
-				}
 
-				if (insert_mos(name, node1, node2, node3, node4, l, w, model_name) == -1){
-					printf("insert_element. Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
-				}
+// parses a large netlist in windows of threads * PARSE_CHUNK_SIZE bytes.
+// The chunks of a window (split at line boundaries) are parsed concurrently,
+// then their lines are stored in file order, so the node ids and the order of
+// the components are the same as the ones of the serial parser. A chunk stops
+// at its first bad line, and the merge reports the first one in file order
+unsigned long parse_cir_parallel(tok_file *F, int threads) {
+	parsed_line **lines = NULL;		// parsed lines of every chunk
+	unsigned long *lines_num = NULL;
+	unsigned long *lines_cap = NULL;
+	char *errors = NULL;			// error message of every chunk
+	byte *failed = NULL;
+	size_t *bounds = NULL;
+	size_t pos = 0;
+	char *end = NULL;
+	unsigned long components_num = 0;
+	unsigned long id = 0;
+	unsigned long k;
+	int t;
+
+	lines = (parsed_line **) calloc(threads, sizeof(parsed_line *));
+	lines_num = (unsigned long *) calloc(threads, sizeof(unsigned long));
+	lines_cap = (unsigned long *) calloc(threads, sizeof(unsigned long));
+	bounds = (size_t *) malloc((threads + 1) * sizeof(size_t));
+	errors = (char *) malloc(threads * PARSE_ERR_SIZE);
+	failed = (byte *) calloc(threads, sizeof(byte));
+	if ((lines == NULL) || (lines_num == NULL) || (lines_cap == NULL) || (bounds == NULL) || \
+		(errors == NULL) || (failed == NULL)) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
 
+	while (pos < F->size) {
 
-				break;
-			case 'Q':
+		// every chunk ends after a newline (or at the end of the file)
+		bounds[0] = pos;
+		for (t = 1; t <= threads; t++) {
+			bounds[t] = bounds[t-1] + PARSE_CHUNK_SIZE;
+			if (bounds[t] >= F->size) {
+				bounds[t] = F->size;
+				continue;
+			}
+			end = (char *) memchr(F->data + bounds[t], '\n', F->size - bounds[t]);
+			bounds[t] = (end == NULL) ? F->size : (size_t)(end - F->data) + 1;
+		}
 
-				node1 = ht_get(node1_name);
-				if (node1 == NULL) {
-					id++;
-					node1 = ht_put(node1_name, id);
+		#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+		for (t = 0; t < threads; t++) {
+			size_t chunk_pos = bounds[t];
+			char *chunk_line;
+			parsed_line Q;
+			byte kind;
+
+			lines_num[t] = 0;
+			while ((chunk_line = tok_range_line(F, &chunk_pos, bounds[t+1])) != NULL) {
+				kind = parse_line(chunk_line, &Q, 0, &errors[t * PARSE_ERR_SIZE]);
+				if (kind == PARSED_NONE)
+					continue;
+				if (kind == PARSED_ERROR) {
+					failed[t] = 1;
+					break;
 				}
 
-
-				node2 = ht_get(node2_name);
-				if (node2 == NULL) {
-					id++;
-					node2 = ht_put(node2_name, id);
+				if (lines_num[t] == lines_cap[t]) {
+					lines_cap[t] = (lines_cap[t] == 0) ? 1024 : 2*lines_cap[t];
+					lines[t] = (parsed_line *) realloc(lines[t], lines_cap[t]*sizeof(parsed_line));
+					if (lines[t] == NULL) {
+						printf("Error. Memory allocation problems. Exiting..\n");
+						exit(EXIT_FAILURE);
+					}
 				}
+				lines[t][lines_num[t]++] = Q;
+			}
+		}
 
-
-				node3 = ht_get(node3_name);
-				if (node3 == NULL) {
-					id++;
-					node3 = ht_put(node3_name, id);
+		// merge the chunks in file order
+		for (t = 0; t < threads; t++) {
+			for (k = 0; k < lines_num[t]; k++) {
+				if (lines[t][k].command != NULL) {
+					if (nc_recording)
+						nc_record_command(lines[t][k].command);
+					parse_command(lines[t][k].command);
 				}
-
-				if (insert_bjt(name, node1, node2, node3, model_name) == -1){
-					printf("insert_element. Memory allocation problems. Exiting..\n");
-					exit(EXIT_FAILURE);
+				else {
+					store_parsed_line(&lines[t][k], &id);
+					components_num++;
 				}
-
-				break;
-			default :
-				printf("Unknown type (%c)\n", toupper(type));
+			}
+			if (failed[t]) {
+				printf("%s", &errors[t * PARSE_ERR_SIZE]);
 				exit(EXIT_FAILURE);
+			}
 		}
 
-
-		// free varialbes as space is being allocated iteratively for each line
-		free(name);
-		free(node1_name);
-		free(node2_name);
-		free(node3_name);
-		free(node4_name);
-		free(model_name);
-
-		printf("\n");
-		/*printf("parsed %s\n", token);*/
-
+		pos = bounds[threads];
+		tok_release(F, pos);
 	}
 
-	fclose(fp);
-	free(line);
+	for (t = 0; t < threads; t++)
+		free(lines[t]);
+	free(lines);
+	free(lines_num);
+	free(lines_cap);
+	free(bounds);
+	free(errors);
+	free(failed);
+
+	return components_num;
 }
 
 
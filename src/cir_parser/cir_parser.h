@@ -1,9 +1,47 @@
 #ifndef _CIR_PARSER_H_
 #define _CIR_PARSER_H_
 
-extern unsigned long get_components_num(char *filename);
-extern void parse_cir(char *filename);
+#include "../tokenizer/tokenizer.h"
+
+// netlists smaller than this are parsed by a single thread
+#define PARSE_PAR_MIN_SIZE		(16 << 20)
+// bytes of the netlist parsed by every thread at a time
+#define PARSE_CHUNK_SIZE		(4 << 20)
+
+// kind of a parsed line
+#define PARSED_NONE			0
+#define PARSED_COMPONENT	1
+#define PARSED_COMMAND		2
+#define PARSED_ERROR		3
+
+// size of the error message kept for a line of the parallel parser
+#define PARSE_ERR_SIZE		512
+
+// a component (or command) line after it is tokenized. The names point
+// into the line, nothing is stored in the node table or the lists yet
+typedef struct parsed_line {
+	char type;
+	char *name;
+	char *node1_name;
+	char *node2_name;
+	char *node3_name;
+	char *node4_name;
+	char *model_name;
+	double val;
+	double l;
+	double w;
+	unsigned char has_G2;
+	int tr_type;
+	void *tran_spec_data;
+	char *command;			// the line of a command, NULL for components
+} parsed_line;
+
+extern unsigned long parse_cir(char *filename);
+extern unsigned long parse_cir_parallel(tok_file *F, int threads);
+extern unsigned char parse_line(char *line, parsed_line *P, unsigned char verbose, char *err);
+extern void store_parsed_line(parsed_line *P, unsigned long *id);
 extern void parse_command(char *command);
 extern unsigned char parse_double(double *d, char *str);
+extern unsigned char parse_double_until(double *d, char *str, char stop);
 extern void strtoupper(char *str);
 #endif
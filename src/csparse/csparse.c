@@ -257,6 +257,34 @@ int cs_ipvec(const int *p, const double *b, double *x, int n) {
 	return (1);
 }
 
+int cs_pvec_block(const int *p, const double *b, double *x, int n, int k) {
+
+	int i, c;
+	const double *bi;
+	if (!x || !b)
+		return (0); /* check inputs */
+	for (i = 0; i < n; i++) {
+		bi = &b[(long) (p ? p[i] : i) * k];
+		for (c = 0; c < k; c++)
+			x[(long) i*k + c] = bi[c];
+	}
+	return (1);
+}
+
+int cs_ipvec_block(const int *p, const double *b, double *x, int n, int k) {
+
+	int i, c;
+	double *xi;
+	if (!x || !b)
+		return (0); /* check inputs */
+	for (i = 0; i < n; i++) {
+		xi = &x[(long) (p ? p[i] : i) * k];
+		for (c = 0; c < k; c++)
+			xi[c] = b[(long) i*k + c];
+	}
+	return (1);
+}
+
 int *cs_pinv(int const *p, int n) {
 
 	int k, *pinv;
@@ -595,6 +623,65 @@ csn *cs_lu (const cs *A, const css *S, double tol)
     return (cs_ndone (N, NULL, xi, x, 1)) ;     /* success */
 }
 
+/* numeric-only LU refactorization. Reuses the pattern of L and U and the pivot
+ * sequence of a previous cs_lu() of a matrix with the same pattern as A.
+ * Returns 0 (N is left unusable) if a pivot is smaller than tol times the largest
+ * entry of its column, in which case cs_lu() must be called again */
+int cs_lu_refactor (const cs *A, const css *S, csn *N, double tol)
+{
+    double pivot, a, t, *Lx, *Ux, *Ax, *x ;
+    int *Lp, *Li, *Up, *Ui, *Ap, *Ai, *pinv, *q, n, k, p, r, j, col ;
+    if (!CS_CSC (A) || !S || !N || !N->L || !N->U || !N->pinv) return (0) ;
+    n = A->n ;
+    q = S->q ; pinv = N->pinv ;
+    Ap = A->p ; Ai = A->i ; Ax = A->x ;
+    Lp = N->L->p ; Li = N->L->i ; Lx = N->L->x ;
+    Up = N->U->p ; Ui = N->U->i ; Ux = N->U->x ;
+    x = cs_calloc (n, sizeof (double)) ;            /* x is in pivot order */
+    if (!x) return (0) ;
+    for (k = 0 ; k < n ; k++)
+    {
+        col = q ? (q [k]) : k ;
+        for (p = Ap [col] ; p < Ap [col+1] ; p++)   /* x = A(:,col) permuted */
+        {
+            x [pinv [Ai [p]]] = Ax [p] ;
+        }
+        /* U(:,k) is stored in topological order, the diagonal last */
+        for (p = Up [k] ; p < Up [k+1] - 1 ; p++)
+        {
+            j = Ui [p] ;
+            Ux [p] = x [j] ;
+            for (r = Lp [j] + 1 ; r < Lp [j+1] ; r++)
+            {
+                x [Li [r]] -= Lx [r] * x [j] ;
+            }
+            x [j] = 0 ;
+        }
+        /* --- Check the fixed pivot ---------------------------------------- */
+        pivot = x [k] ;
+        a = 0 ;
+        for (p = Lp [k] ; p < Lp [k+1] ; p++)
+        {
+            if ((t = fabs (x [Li [p]])) > a) a = t ;
+        }
+        if (a <= 0 || fabs (pivot) < a*tol)
+        {
+            cs_free (x) ;
+            return (0) ;
+        }
+        Ux [Up [k+1] - 1] = pivot ;
+        Lx [Lp [k]] = 1 ;
+        x [k] = 0 ;
+        for (p = Lp [k] + 1 ; p < Lp [k+1] ; p++)   /* L(k+1:n,k) = x / pivot */
+        {
+            Lx [p] = x [Li [p]] / pivot ;
+            x [Li [p]] = 0 ;
+        }
+    }
+    cs_free (x) ;
+    return (1) ;
+}
+
 int cs_lsolve(const cs *L, double *x) {
 
 	int p, j, n, *Lp, *Li;
@@ -650,6 +737,101 @@ int cs_ltsolve(const cs *L, double *x) {
 	return (1);
 }
 
+static inline int cs_lsolve_block_k(const cs *L, double *X, const int k) {
+
+	int p, j, n, c, *Lp, *Li;
+	double *Lx, *xj, *xi, d;
+	if (!CS_CSC (L) || !X)
+		return (0); /* check inputs */
+	n = L->n;
+	Lp = L->p;
+	Li = L->i;
+	Lx = L->x;
+	for (j = 0; j < n; j++) {
+		xj = &X[(long) j*k];
+		d = Lx[Lp[j]];
+		for (c = 0; c < k; c++)
+			xj[c] /= d;
+		for (p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+			xi = &X[(long) Li[p]*k];
+			#pragma omp simd
+			for (c = 0; c < k; c++)
+				xi[c] -= Lx[p] * xj[c];
+		}
+	}
+	return (1);
+}
+
+static inline int cs_usolve_block_k(const cs *U, double *X, const int k) {
+
+	int p, j, n, c, *Up, *Ui;
+	double *Ux, *xj, *xi, d;
+	if (!CS_CSC (U) || !X)
+		return (0); /* check inputs */
+	n = U->n;
+	Up = U->p;
+	Ui = U->i;
+	Ux = U->x;
+	for (j = n - 1; j >= 0; j--) {
+		xj = &X[(long) j*k];
+		d = Ux[Up[j + 1] - 1];
+		for (c = 0; c < k; c++)
+			xj[c] /= d;
+		for (p = Up[j]; p < Up[j + 1] - 1; p++) {
+			xi = &X[(long) Ui[p]*k];
+			#pragma omp simd
+			for (c = 0; c < k; c++)
+				xi[c] -= Ux[p] * xj[c];
+		}
+	}
+	return (1);
+}
+
+static inline int cs_ltsolve_block_k(const cs *L, double *X, const int k) {
+
+	int p, j, n, c, *Lp, *Li;
+	double *Lx, *xj, *xi, d;
+	if (!CS_CSC (L) || !X)
+		return (0); /* check inputs */
+	n = L->n;
+	Lp = L->p;
+	Li = L->i;
+	Lx = L->x;
+	for (j = n - 1; j >= 0; j--) {
+		xj = &X[(long) j*k];
+		for (p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+			xi = &X[(long) Li[p]*k];
+			#pragma omp simd
+			for (c = 0; c < k; c++)
+				xj[c] -= Lx[p] * xi[c];
+		}
+		d = Lx[Lp[j]];
+		for (c = 0; c < k; c++)
+			xj[c] /= d;
+	}
+	return (1);
+}
+
+/* a block of CS_BLOCK_WIDTH columns gets its own copy with a constant width,
+ * which the compiler unrolls and vectorizes */
+int cs_lsolve_block(const cs *L, double *X, int k) {
+	if (k == CS_BLOCK_WIDTH)
+		return (cs_lsolve_block_k(L, X, CS_BLOCK_WIDTH));
+	return (cs_lsolve_block_k(L, X, k));
+}
+
+int cs_usolve_block(const cs *U, double *X, int k) {
+	if (k == CS_BLOCK_WIDTH)
+		return (cs_usolve_block_k(U, X, CS_BLOCK_WIDTH));
+	return (cs_usolve_block_k(U, X, k));
+}
+
+int cs_ltsolve_block(const cs *L, double *X, int k) {
+	if (k == CS_BLOCK_WIDTH)
+		return (cs_ltsolve_block_k(L, X, CS_BLOCK_WIDTH));
+	return (cs_ltsolve_block_k(L, X, k));
+}
+
 int cs_lusol (int order, const cs *A, double *b, double tol)
 {
     double *x ;
@@ -1395,7 +1577,21 @@ int *cs_amd(int order, const cs *A) {/* order 0:natural, 1:Chol, 2:LU, 3:QR */
 
 css *cs_schol(int order, const cs *A) {
 
-	int n, *c, *post, *P;
+	int *P;
+	css *S;
+	if (!CS_CSC (A))
+		return (NULL); /* check inputs */
+	P = cs_amd(order, A); /* P = amd(A+A'), or natural */
+	if (order && !P)
+		return (NULL);
+	S = cs_schol_perm(P, A);
+	cs_free(P);
+	return (S);
+}
+
+css *cs_schol_perm(const int *P, const cs *A) {
+
+	int n, *c, *post;
 	cs *C;
 	css *S;
 	if (!CS_CSC (A))
@@ -1404,10 +1600,8 @@ css *cs_schol(int order, const cs *A) {
 	S = (css *) cs_calloc(1, sizeof(css)); /* allocate result S */
 	if (!S)
 		return (NULL); /* out of memory */
-	P = cs_amd(order, A); /* P = amd(A+A'), or natural */
 	S->pinv = cs_pinv(P, n); /* find inverse permutation */
-	cs_free(P);
-	if (order && !S->pinv)
+	if (P && !S->pinv)
 		return (cs_sfree(S));
 	C = cs_symperm(A, S->pinv, 0); /* C = spones(triu(A(P,P))) */
 	S->parent = cs_etree(C, 0); /* find etree of C */
@@ -235,6 +235,20 @@ int cs_pvec(const int *p, const double *b, double *x, int n);
 int cs_ipvec(const int *p, const double *b, double *x, int n);
 
 
+/**
+ *  Functions that apply cs_pvec() and cs_ipvec() to k vectors at once.
+ *  The vectors are stored by rows: entry i of vector c is at [i*k + c].
+ *  @param p The permutation vector. If p==NULL then the permutation vector is the identity vector.
+ *  @param b Input vectors.
+ *  @param x Output vectors.
+ *  @param n Vector length.
+ *  @param k Number of vectors.
+ *  @return 1 if successful and 0 in case of error.
+ */
+int cs_pvec_block(const int *p, const double *b, double *x, int n, int k);
+int cs_ipvec_block(const int *p, const double *b, double *x, int n, int k);
+
+
 /**
  *  Function that inverts a permutation vector.
  *  @param p The permutation vector.
@@ -335,6 +349,17 @@ int cs_fkeep(cs *A, int(*fkeep)(int, int, double, void *), void *other);
  */
 csn *cs_lu (const cs *A, const css *S, double tol) ;
 
+/*
+ *  Function that recomputes the values of an LU decomposition, keeping the L and U
+ *  pattern and the pivot sequence of a previous cs_lu() of a matrix with the same pattern.
+ *  @param A Sparse matrix.
+ *  @param S The symbolic analysis that was used by cs_lu().
+ *  @param N The numerical analysis computed by cs_lu(). Its values are overwritten.
+ *  @param tol Minimum ratio of a fixed pivot to the largest entry of its column.
+ *  @return 1 if successful, 0 if a pivot is too small (cs_lu() must be used instead).
+ */
+int cs_lu_refactor (const cs *A, const css *S, csn *N, double tol) ;
+
 /**
  *  Function for solving a sparse lower triangular system Lx = b.
  *  @param L The lower triangular matrix. Matrix must have a zero-free diagonal.
@@ -362,6 +387,21 @@ int cs_usolve (const cs *U, double *x);
 int cs_ltsolve(const cs *L, double *x);
 
 
+/**
+ *  Functions that solve Lx = b, Ux = b and L'x = b for k right-hand sides at once,
+ *  traversing the factor a single time. The vectors are stored by rows: entry i of
+ *  vector c is at [i*k + c].
+ *  @param L The triangular matrix (U for cs_usolve_block()). Matrix must have a zero-free diagonal.
+ *  @param X The right-hand side vectors on input and the solutions on output.
+ *  @param k Number of right-hand sides.
+ *  @return 1 if successful and 0 in case of error.
+ */
+#define CS_BLOCK_WIDTH 8		/* block width with a specialized solve */
+int cs_lsolve_block(const cs *L, double *X, int k);
+int cs_usolve_block(const cs *U, double *X, int k);
+int cs_ltsolve_block(const cs *L, double *X, int k);
+
+
 /*
  *  Function that solves x=A\b. where A is unsymmetric; b overwritten with solution
  *  @param order The ordering method that will be used (0:natural, 1:Chol, 2:LU, 3:QR).
@@ -533,6 +573,16 @@ int *cs_amd(int order, const cs *A);
 css *cs_schol(int order, const cs *A);
 
 
+/**
+ *  Function that computes the symbolic analysis for a Cholesky factorization
+ *  with a given fill-reducing ordering.
+ *  @param P The permutation of size n (A(P,P) is factorized) or NULL for natural ordering.
+ *  @param A Matrix to factorize.
+ *  @return The symbolic analysis for cs_chol() function or NULL on error.
+ */
+css *cs_schol_perm(const int *P, const cs *A);
+
+
 /**
  *  Function that computes the sparse Cholesky factorization of a matrix.
  *  @param A Matrix to factorize.
@@ -11,15 +11,61 @@
 hashtable_t *HashTable = NULL;
 element_h **id_to_node = NULL;
 unsigned long total_ids = 0;
+unsigned long id_capacity = 0;	// allocated entries of id_to_node
+
+// the nodes are stored one after the other in large chunks, every record
+// followed by its name, so that a lookup reads both from the same cache line.
+// A chunk never moves, so the nodes can be pointed to by the lists and id_to_node
+typedef struct node_chunk {
+	struct node_chunk *next;
+	size_t used;
+	size_t size;
+	char data[];
+} node_chunk;
+
+node_chunk *node_arena = NULL;
+
+
+// returns room for a node record followed by a name of len bytes (with its '\0')
+static element_h *ht_node_alloc(size_t len) {
+	node_chunk *chunk = NULL;
+	size_t need = (sizeof(element_h) + len + 7) & ~((size_t) 7);	// keeps records aligned
+	size_t size = HT_NODE_CHUNK;
+
+	if ((node_arena == NULL) || (node_arena->used + need > node_arena->size)) {
+		if (need > size)
+			size = need;
+		chunk = (node_chunk *)malloc(sizeof(node_chunk) + size);
+		if (chunk == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+		chunk->next = node_arena;
+		chunk->used = 0;
+		chunk->size = size;
+		node_arena = chunk;
+	}
+
+	node_arena->used += need;
+	return (element_h *)&node_arena->data[node_arena->used - need];
+}
 
 
 void add_id_to_list(element_h *node, unsigned long id) {
 	total_ids = id+1;
 
-	id_to_node = (element_h **)realloc(id_to_node, sizeof(element_h *)*total_ids);
-	if (id_to_node == NULL) {
-		printf("Error. Memory allocation problems. Exiting..\n");
-		exit(EXIT_FAILURE);
+	// the id array doubles when full, so that a netlist of any size
+	// is read without knowing its number of nodes in advance
+	if (total_ids > id_capacity) {
+		id_capacity = (id_capacity == 0) ? HT_INIT_SIZE : 2*id_capacity;
+		if (id_capacity < total_ids)
+			id_capacity = total_ids;
+
+		id_to_node = (element_h **)realloc(id_to_node, sizeof(element_h *)*id_capacity);
+		if (id_to_node == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	id_to_node[total_ids-1] = node;
@@ -30,6 +76,7 @@ void free_id_list() {
 	free(id_to_node);
 	id_to_node = NULL;
 	total_ids = 0;
+	id_capacity = 0;
 }
 
 
@@ -45,113 +92,166 @@ void print_id_list() {
 }
 
 
+// size is rounded up to a power of two
 void ht_init(unsigned long size){
 
-	int i;
+	unsigned long slots = 1;
 
 
 	if(size <= 0)
 		return;
 
+	while (slots < size)
+		slots <<= 1;
+
 
 	HashTable = (hashtable_t *)malloc(sizeof(hashtable_t));
 	if(HashTable==NULL){
 		 perror("Error malloc: ");
 	}
 
-	HashTable->table = (element_h **)malloc(size*sizeof(element_h *));
+	HashTable->table = (ht_slot *)calloc(slots, sizeof(ht_slot));
 	if(HashTable->table==NULL){
 		 perror("Error malloc: ");
 	}
 
-	for(i=0 ; i < size; i++){
-		HashTable->table[i]=NULL;
+	HashTable->size = slots;
+	HashTable->capacity = 0;
+}
+
+
+// places node (whose name hashes to hash) in table, which has room for it.
+// The node takes the slot of any node that is closer to its home slot
+static void ht_place(ht_slot *table, unsigned long mask, unsigned long hash, element_h *node) {
+	ht_slot slot = {hash, node};
+	ht_slot tmp;
+	unsigned long index = hash & mask;
+	unsigned long dist = 0;		// distance of slot from its home
+	unsigned long other;		// distance of the node in table[index] from its home
+
+	while (table[index].node != NULL) {
+		other = (index - table[index].hash) & mask;
+		if (other < dist) {
+			tmp = table[index];
+			table[index] = slot;
+			slot = tmp;
+			dist = other;
+		}
+		index = (index + 1) & mask;
+		dist++;
 	}
+	table[index] = slot;
+}
+
 
-	/*
-		prosthiki kai allwn stoixeiwn
+// doubles the slots of the table and moves every node to its new slot.
+// The names are not hashed again
+void ht_resize() {
+	ht_slot *table = NULL;
+	unsigned long size = 2*HashTable->size;
+	unsigned long i;
+
+	table = (ht_slot *)calloc(size, sizeof(ht_slot));
+	if (table == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
 
-	*/
+	for (i = 0; i < HashTable->size; i++) {
+		if (HashTable->table[i].node != NULL)
+			ht_place(table, size - 1, HashTable->table[i].hash, HashTable->table[i].node);
+	}
 
+	free(HashTable->table);
+	HashTable->table = table;
 	HashTable->size = size;
-	HashTable->capacity = 0;
 }
 
 
-unsigned long hs_function(unsigned long size_hs, char *name ){
+// the characters are folded in base 257 (a one to one mapping for names of
+// up to 7 characters), then mixed so that the low bits used to pick a slot
+// depend on every character
+unsigned long hs_function(char *name){
 
-	unsigned long val=0;
-	int i = 0;
-	int size = (int)strlen(name);
+	unsigned long val = 0;
 
-	while(i < size){
-		val += (val << 8) + name[ i ];
-		i++;
-	}
+	for (; *name != '\0'; name++)
+		val += (val << 8) + (unsigned char) *name;
+
+	val ^= val >> 33;
+	val *= 0xff51afd7ed558ccdUL;
+	val ^= val >> 33;
 
-	return val%size_hs;
+	return val;
 }
 
 
 element_h *newElement(char *name, unsigned long id){
 
 	element_h *element;
+	size_t len = strlen(name) + 1;
 
-	element = (element_h *)malloc(sizeof(element_h));
-	if(element == NULL){
-		perror("Error malloc: ");
-	}
-
-	element->name=strdup(name);
-	if(element->name == NULL){
-		perror("Error strdup: ");
-	}
+	element = ht_node_alloc(len);
 
+	element->name = (char *)(element + 1);
+	memcpy(element->name, name, len);
 	element->id = id;
-	element->next = NULL;
+	element->val = 0;
 
 	return element;
 }
 
 
+// returns the slot of the node called name (that hashes to hash), or NULL.
+// The search stops at an empty slot or at a node closer to its home
+// than name would be, as name would have taken its slot
+static ht_slot *ht_find(char *name, unsigned long hash) {
+	unsigned long mask = HashTable->size - 1;
+	unsigned long index = hash & mask;
+	unsigned long dist;
+
+	for (dist = 0; HashTable->table[index].node != NULL; dist++) {
+		if (((index - HashTable->table[index].hash) & mask) < dist)
+			break;
+		if ((HashTable->table[index].hash == hash) &&
+			(strcmp(HashTable->table[index].node->name, name) == 0))
+			return &HashTable->table[index];
+		index = (index + 1) & mask;
+	}
 
-element_h *ht_put(char *name, unsigned long id) {
+	return NULL;
+}
 
-	element_h *curr= NULL;
-	element_h *prev= NULL;
-	unsigned long index = 0;
 
-	strtoupper(name);
-	index = hs_function(HashTable->size, name);
+// adds a new node, growing the table when it is HT_MAX_LOAD percent full
+static element_h *ht_add(char *name, unsigned long hash, unsigned long id) {
+	element_h *node;
 
+	if (100*(HashTable->capacity + 1) > HT_MAX_LOAD*HashTable->size)
+		ht_resize();
 
-	if(HashTable->table[index] == NULL){
-		HashTable->table[index]=newElement(name,id);
-		HashTable->capacity++;
+	node = newElement(name, id);
+	ht_place(HashTable->table, HashTable->size - 1, hash, node);
+	HashTable->capacity++;
 
-		// add the id to the id array
-		add_id_to_list(HashTable->table[index], id);
-		return HashTable->table[index];
+	// add the id to the id array
+	add_id_to_list(node, id);
+	return node;
+}
 
-	}else{
-		curr = HashTable->table[index];
-		while((curr!=NULL) && (strcmp(curr->name,name)!=0)){
 
-			prev=curr;
-			curr=curr->next;
-		}
+// adds the node called name with the given id. Returns NULL if it exists
+element_h *ht_put(char *name, unsigned long id) {
 
+	unsigned long hash;
 
-		if(curr == NULL){
-			prev->next=newElement(name,id);
+	strtoupper(name);
+	hash = hs_function(name);
 
-			// add the id to the id array
-			add_id_to_list(prev->next, id);
-			return prev->next;
-		}
-	}
+	if (ht_find(name, hash) != NULL)
+		return NULL;
 
-	return NULL;
+	return ht_add(name, hash, id);
 }
 
 
@@ -160,68 +260,65 @@ element_h *ht_put(char *name, unsigned long id) {
 //	 otherwise it contains the pointer of the node
 element_h *ht_get(char *name) {
 
-	unsigned long index = 0;
-	element_h *curr=NULL;
+	ht_slot *slot;
 
 	strtoupper(name);
-	index = hs_function(HashTable->size,name);
+	slot = ht_find(name, hs_function(name));
 
-	curr = HashTable->table[index];
-	while((curr!=NULL) && (strcmp(curr->name,name)!=0)){
-			curr = curr->next;
-	}
+	return (slot == NULL) ? NULL : slot->node;
+}
+
+
+// returns the node called name. A new node is added with id ++(*id)
+// when it does not exist (a single hash and search, unlike ht_get + ht_put)
+element_h *ht_get_or_put(char *name, unsigned long *id) {
 
-	return curr;
+	unsigned long hash;
+	ht_slot *slot;
+
+	strtoupper(name);
+	hash = hs_function(name);
+
+	slot = ht_find(name, hash);
+	if (slot != NULL)
+		return slot->node;
+
+	(*id)++;
+	return ht_add(name, hash, *id);
 }
 
 
 
 void printHastable(){
-	int i;
+	unsigned long i;
 	element_h *curr= NULL;
 
 
 	printf("\t**************HashTable**************** \n");
 
-	printf("\tSize  : %d\n",HashTable->size);
+	printf("\tSize  : %lu\n",HashTable->size);
 	for(i=0;i < HashTable->size;i++){
 
-		curr = HashTable->table[i];
-
-		printf(" %d ",i);
-		while(curr != NULL){
-			printf("-> (%s%s%s , %s%lu%s)",RED,curr->name, NRM, GRN, curr->id, NRM);
-
-			curr=curr->next;
-		}
-		printf("\n");
+		curr = HashTable->table[i].node;
+		if (curr == NULL)
+			continue;
 
+		printf(" %lu -> (%s%s%s , %s%lu%s)\n",i,RED,curr->name, NRM, GRN, curr->id, NRM);
 	}
 }
 
 void freeHashTable(){
 
-	int i;
-	element_h *curr = NULL;
-	element_h *prev = NULL;
-
-	for(i = 0; i < HashTable->size ; i++){
-		curr = HashTable->table[i];
-		while(curr!= NULL){
-			prev=curr;
-			curr = curr->next;
+	node_chunk *chunk = NULL;
 
-			free(prev->name);
-			prev->name = NULL;
-			free(prev);
-			prev = NULL;
-
-		}
+	free_id_list();
 
+	while (node_arena != NULL) {
+		chunk = node_arena;
+		node_arena = chunk->next;
+		free(chunk);
 	}
 
-	free_id_list();
-
 	free(HashTable->table);
 	HashTable->table = NULL;
 
@@ -2,6 +2,11 @@
 #define __HASHTABLE_H__
 
 
+#define HT_INIT_SIZE	1024	// initial slots of the node table (a power of two)
+#define HT_MAX_LOAD		80		// percentage of the slots in use before the table doubles
+#define HT_NODE_CHUNK	65536	// bytes of every chunk of the node arena (records and names)
+
+
 typedef struct element_h{
 	char *name;	// name
 	unsigned long id;
@@ -9,15 +14,26 @@ typedef struct element_h{
 	// according to the connection type
 
 	double val;
-	struct element_h *next;
 
 }element_h;
 
 
+// a slot of the table. The hash of the name is kept next to the node,
+// so a probe compares names only when their hashes are equal
+typedef struct ht_slot{
+	unsigned long hash;
+	element_h *node;	// NULL: empty slot
+
+}ht_slot;
+
+
+// open addressing table with robin hood probing: a node is moved further
+// from its home slot only when it is closer to its own home than the node it
+// passes, so every probe sequence stays short and within a few cache lines
 typedef struct hashtable_t{
-	int size;
-	int capacity;
-	struct element_h **table;
+	unsigned long size;		// number of slots
+	unsigned long capacity;	// number of nodes stored
+	ht_slot *table;
 
 }hashtable_t;
 
@@ -27,10 +43,12 @@ extern element_h **id_to_node;
 extern unsigned long total_ids;
 
 extern void ht_init(unsigned long size);
-extern unsigned long hs_function(unsigned long size_hs, char *name);
+extern void ht_resize();
+extern unsigned long hs_function(char *name);
 extern element_h *newElement(char *name,unsigned long id);
 extern element_h *ht_put(char *name, unsigned long id);
 extern element_h * ht_get(char *name);
+extern element_h *ht_get_or_put(char *name, unsigned long *id);
 extern void printHastable();
 extern void freeHashTable();
 
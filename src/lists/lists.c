@@ -6,6 +6,7 @@
 #include "../spicy.h"
 #include "lists.h"
 #include "../mna/mna.h"
+#include "../spmv/spmv.h"
 
 
 list_head team1_list;
@@ -34,6 +35,7 @@ void add_command_to_list(char *command) {
 	char *token = NULL;
 	const char delim[5] = " \r\t\n";
 	unsigned int tok_count = 0;
+	double num_val;	// value of the numeric options
 
 	/*printf("COMMAND: %s\n", command);*/
 
@@ -53,7 +55,7 @@ void add_command_to_list(char *command) {
 
 				// we assume that the user knows what he does and he does not give
 				// the same option multiple times
-				if (solver_type == BI_CG_SOLVER)
+				if (IS_NONSYM_ITER(solver_type))
 					solver_type = CG_SOLVER;
 				else if (solver_type  != CG_SOLVER)
 					solver_type = CHOL_SOLVER;
@@ -66,7 +68,34 @@ void add_command_to_list(char *command) {
 				if (solver_type == CHOL_SOLVER)
 					solver_type = CG_SOLVER;
 				else if (solver_type != CG_SOLVER)
-					solver_type = BI_CG_SOLVER;
+					solver_type = nonsym_solver_type;
+			}
+			else if (strncmp(token, "ITER_SOLVER", 11) == 0) {
+				// iterative method used when the array is not SPD
+				if (strcmp(&token[12], "BICGSTAB") == 0) {
+					nonsym_solver_type = BICGSTAB_SOLVER;
+				}
+				else if (strcmp(&token[12], "GMRES") == 0) {
+					nonsym_solver_type = GMRES_SOLVER;
+				}
+				else if (strcmp(&token[12], "BICG") == 0) {
+					nonsym_solver_type = BI_CG_SOLVER;
+				}
+				else {
+					printf(YEL "Warning:" NRM "Unknown iterative solver. Bypassing\n");
+				}
+
+				if (IS_NONSYM_ITER(solver_type))
+					solver_type = nonsym_solver_type;
+			}
+			else if (strncmp(token, "GMRES_RESTART", 13) == 0) {
+				// size of the Krylov basis of GMRES(m)
+				if ((parse_double(&num_val, &token[14]) == 0) || (num_val < 1)) {
+					printf(YEL "Warning:" NRM "Invalid GMRES restart. Bypassing\n");
+				}
+				else {
+					gmres_restart = (unsigned int)num_val;
+				}
 			}
 			else if (strncmp(token, "ITOL", 4) == 0) {
 				// update itol
@@ -88,6 +117,43 @@ void add_command_to_list(char *command) {
 					printf(YEL "Warning:" NRM "Unknown transient analysis method. Bypassing\n");
 				}
 			}
+			else if (strncmp(token, "PRECOND", 7) == 0) {
+				// preconditioner of the iterative methods. For a symmetric array
+				// ILU(0) is the same preconditioner as IC(0)
+				if ((strcmp(&token[8], "ILU0") == 0) || (strcmp(&token[8], "IC0") == 0)) {
+					precond_type = ILU0_PRECOND;
+				}
+				else if (strcmp(&token[8], "AMG") == 0) {
+					precond_type = AMG_PRECOND;
+				}
+				else if (strcmp(&token[8], "JACOBI") == 0) {
+					precond_type = JACOBI_PRECOND;
+				}
+				else {
+					printf(YEL "Warning:" NRM "Unknown preconditioner. Bypassing\n");
+				}
+			}
+			else if (strncmp(token, "ORDER", 5) == 0) {
+				// fill-reducing ordering of the sparse LU and Cholesky factorizations
+				if (strcmp(&token[6], "AMD") == 0) {
+					order_type = ORDER_AMD;
+				}
+				else if (strcmp(&token[6], "ND") == 0) {
+					order_type = ORDER_ND;
+				}
+				else {
+					printf(YEL "Warning:" NRM "Unknown ordering. Bypassing\n");
+				}
+			}
+			else if (strncmp(token, "THREADS", 7) == 0) {
+				// number of threads of the sparse matrix-vector products
+				if ((parse_double(&num_val, &token[8]) == 0) || (num_val < 1)) {
+					printf(YEL "Warning:" NRM "Invalid number of threads. Bypassing\n");
+				}
+				else {
+					spmv_threads = (int)num_val;
+				}
+			}
 			// else bypass argument
 
 			token = strtok(NULL, delim);
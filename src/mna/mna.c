@@ -11,6 +11,12 @@
 #include "../cir_parser/cir_parser.h"
 #include "../spicy.h"
 #include "../hashtable/hashtable.h"
+#include "../precond/precond.h"
+#include "../spmv/spmv.h"
+#include "../vecops/vecops.h"
+#include "../trisolve/trisolve.h"
+#include "../supernodal/supernodal.h"
+#include "../ordering/ordering.h"
 #include "mna.h"
 
 // variables regarding the MNA system
@@ -38,11 +44,20 @@ cs *compr_col_A = NULL;
 css *css_S = NULL;
 csn *csn_N = NULL;
 
+// sparsity pattern (no values) that css_S was computed for
+cs *css_S_pattern = NULL;
+// supernodal analysis of the Cholesky factorization, kept with css_S
+super_sym *super_Y = NULL;
+
+// level schedules of the two triangular solves of the sparse LU or Cholesky factors
+tri_sched *tri_L = NULL;
+tri_sched *tri_U = NULL;
+
 // used for transient analysis
 cs *triplet_C = NULL;
 cs *compr_col_C = NULL;
 cs *compr_col_G = NULL;
-cs *compr_col_temp = NULL;
+cs *compr_row_H = NULL;	// history matrix, compressed column form of H' (the rows of H)
 
 // variables used for Trans
 double *B_vector = NULL;
@@ -68,22 +83,181 @@ gsl_vector *gsl_rT_vector = NULL;
 gsl_vector *gsl_pT_vector = NULL;
 gsl_vector *gsl_qT_vector = NULL;
 gsl_permutation *gsl_p = NULL;
-double *p_vector = NULL;
-double *q_vector = NULL;
+cs *compr_col_AT = NULL;
+
+// GMRES(m) workspace: the m+1 basis vectors, the Hessenberg array (column j
+// at H + j*(m+1)) and the Givens rotations that reduce it to triangular form
+double *gmres_V = NULL;
+double *gmres_H = NULL;
+double *gmres_c = NULL;
+double *gmres_s = NULL;
+double *gmres_g = NULL;
+double *gmres_y = NULL;
+unsigned int gmres_restart = GMRES_RESTART_DEFAULT;
+
+// DC sweep workspace: DC_BLOCK_SIZE right-hand sides stored by rows
+// (entry (i, c) at [i*DC_BLOCK_SIZE + c]). R, Z, P and Q are used by block CG
+double *block_B = NULL;
+double *block_X = NULL;
+double *block_R = NULL;
+double *block_Z = NULL;
+double *block_P = NULL;
+double *block_Q = NULL;
+double block_vals[DC_BLOCK_SIZE];	// sweep values of the queued right-hand sides
+int block_len = 0;
+
+// the two last solved sweep points (the last one is gsl_x_vector). The
+// right-hand side is affine in the swept value and so is the solution, which
+// makes the line through them a close initial guess for the next block
+double *block_x_prev = NULL;
+double block_val_prev = 0.0;
+double block_val_last = 0.0;
+int block_known = 0;
 
 byte solver_type = LU_SOLVER;
+byte nonsym_solver_type = BICGSTAB_SOLVER;	// solver picked by ITER for nonsymmetric arrays
+byte precond_type = JACOBI_PRECOND;		// preconditioner asked for by .OPTIONS
+byte active_precond = JACOBI_PRECOND;	// preconditioner in use for the current array
+byte order_type = ORDER_AMD;
 byte tr_method = TRAPEZOIDAL;
 byte is_sparse = 0;
 byte is_trans = 0;
 
 double itol = ITOL_DEFAULT;
 
+// returns 1 if A and B have exactly the same compressed column structure, otherwise 0
+byte same_sparsity_pattern(cs *A, cs *B) {
+	int nz;
+
+	if ((A == NULL) || (B == NULL))
+		return 0;
+
+	if ((A->m != B->m) || (A->n != B->n))
+		return 0;
+
+	if (memcmp(A->p, B->p, (A->n + 1)*sizeof(int)) != 0)
+		return 0;
+
+	nz = A->p[A->n];
+	if (memcmp(A->i, B->i, nz*sizeof(int)) != 0)
+		return 0;
+
+	return 1;
+}
+
+
+// returns 1 when compr_col_A no longer has the pattern that css_S was computed for.
+// In that case css_S and super_Y are freed and the new pattern is stored,
+// so the caller has to redo the analysis
+byte symbolic_needs_update() {
+	int nz;
+
+	if ((css_S != NULL) && same_sparsity_pattern(compr_col_A, css_S_pattern))
+		return 0;
+
+	if (css_S)
+		cs_sfree(css_S);
+	css_S = NULL;
+	super_sym_free(super_Y);
+	super_Y = NULL;
+
+	if (css_S_pattern)
+		cs_spfree(css_S_pattern);
+
+	nz = compr_col_A->p[compr_col_A->n];
+	css_S_pattern = cs_spalloc(compr_col_A->m, compr_col_A->n, nz, 0, 0);
+	if (css_S_pattern == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(css_S_pattern->p, compr_col_A->p, (compr_col_A->n + 1)*sizeof(int));
+	memcpy(css_S_pattern->i, compr_col_A->i, nz*sizeof(int));
+
+	return 1;
+}
+
+
+// fill-reducing ordering and symbolic analysis of compr_col_A,
+// for a Cholesky (chol = 1) or an LU factorization
+css *symbolic_analysis(byte chol) {
+	css *S;
+	int *P;
+
+	if (order_type == ORDER_ND) {
+		P = nd_order(compr_col_A);
+		if (P == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+		if (chol) {
+			S = cs_schol_perm(P, compr_col_A);
+			cs_free(P);
+		}
+		else {
+			// the columns are permuted by P, the rows by the pivoting
+			S = cs_sqr(0, compr_col_A, 0);
+			if (S)
+				S->q = P;
+			else
+				cs_free(P);
+		}
+	}
+	else {
+		S = chol ? cs_schol(1, compr_col_A) : cs_sqr(2, compr_col_A, 0);
+	}
+
+	if (S == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	return S;
+}
+
+
+// prints the fill-in of a new factorization. U is NULL for Cholesky (U = L')
+void print_fill_stats(cs *L, cs *U) {
+	double nnz_A, nnz_F;
+
+	nnz_A = compr_col_A->p[compr_col_A->n];
+	nnz_F = U ? (L->p[L->n] + U->p[U->n] - L->n) : (2.0 * L->p[L->n] - L->n);
+	printf("FILL-IN (%s): nnz(A) = %.0f, nnz(L+U) = %.0f, ratio = %.2f\n",
+			(order_type == ORDER_ND) ? "ND" : "AMD", nnz_A, nnz_F, nnz_F / nnz_A);
+}
+
+
 void decomp_lu() {
 	int s;
+	byte new_symbolic;
 
 	if (is_sparse) {
-		css_S = cs_sqr(2, compr_col_A, 0);
-		csn_N = cs_lu(compr_col_A, css_S, 1);
+		// the ordering only depends on the pattern of A, which is
+		// the same for the DC array and for every timestep
+		new_symbolic = symbolic_needs_update();
+		if (new_symbolic) {
+			css_S = symbolic_analysis(0);
+			if (csn_N)
+				cs_nfree(csn_N);
+			csn_N = NULL;
+		}
+
+		// same pattern as the previous factorization: only the values of L and U
+		// are recomputed, using the previous pivot sequence while it stays stable
+		if ((csn_N == NULL) || (cs_lu_refactor(compr_col_A, css_S, csn_N, LU_REFACTOR_TOL) == 0)) {
+			if (csn_N)
+				cs_nfree(csn_N);
+			csn_N = cs_lu(compr_col_A, css_S, 1);
+		}
+		if (new_symbolic)
+			print_fill_stats(csn_N->L, csn_N->U);
+
+		tri_sched_free(tri_L);
+		tri_sched_free(tri_U);
+		tri_L = tri_sched_init(csn_N->L, TRI_LSOLVE);
+		tri_U = tri_sched_init(csn_N->U, TRI_USOLVE);
+		if ((tri_L == NULL) || (tri_U == NULL)) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
 		/*cs_spfree(compr_col_A);*/
 		//compr_col_A = NULL;
 	}
@@ -102,10 +276,42 @@ void decomp_lu() {
 }
 
 void decomp_cholesky() {
+	byte new_symbolic;
+	int status;
 
 	if (is_sparse) {
-		css_S = cs_schol(1, compr_col_A);
-		csn_N = cs_chol(compr_col_A, css_S);
+		new_symbolic = symbolic_needs_update();
+		if (new_symbolic)
+			css_S = symbolic_analysis(1);
+		if (super_Y == NULL) {
+			// fails on memory, or when the factor does not fit in int indices
+			super_Y = super_analyze(compr_col_A, css_S);
+			if (super_Y == NULL) {
+				printf("Error. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		if (csn_N)
+			cs_nfree(csn_N);
+		csn_N = super_chol(compr_col_A, css_S, super_Y, &status);
+		if (csn_N == NULL) {
+			if (status == SUPER_NOT_POSDEF)
+				printf("Error. Cholesky decomposition failed (array not positive definite). Exiting..\n");
+			else
+				printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+		if (new_symbolic)
+			print_fill_stats(csn_N->L, NULL);
+
+		tri_sched_free(tri_L);
+		tri_sched_free(tri_U);
+		tri_L = tri_sched_init(csn_N->L, TRI_LSOLVE);
+		tri_U = tri_sched_init(csn_N->L, TRI_LTSOLVE);
+		if ((tri_L == NULL) || (tri_U == NULL)) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
 		/*cs_spfree(compr_col_A);*/
 		/*compr_col_A = NULL;*/
 	}
@@ -124,22 +330,22 @@ void decomp_cholesky() {
 void initialise_iter_methods() {
 	unsigned long i,p;
 	int k;
+	int amg_status;
 
 
 	if(is_sparse){
 
-		p_vector = (double *) calloc(mna_dimension_size,sizeof(double));
-		if (p_vector == NULL) {
-			printf("Error. Memory allocation problems. Exiting..\n");
-			exit(EXIT_FAILURE);
-		}
-
-		// this is necessary as a helping/temporary vector.
-		// the same helper vector can be used in solve qT aswell
-		q_vector = (double *) calloc(mna_dimension_size,sizeof(double));
-		if (q_vector == NULL) {
-			printf("Error. Memory allocation problems. Exiting..\n");
-			exit(EXIT_FAILURE);
+		// q = A.p is computed row by row from the transpose, so that every
+		// entry of q is written once (CG arrays are symmetric and need no transpose)
+		if (compr_col_AT)
+			cs_spfree(compr_col_AT);
+		compr_col_AT = NULL;
+		if (IS_NONSYM_ITER(solver_type)) {
+			compr_col_AT = cs_transpose(compr_col_A, 1);
+			if (compr_col_AT == NULL) {
+				printf("Error. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
 		}
 
 		gsl_mna_vector = gsl_vector_view_array(mna_vector, mna_dimension_size);
@@ -150,7 +356,7 @@ void initialise_iter_methods() {
 		for(k = 0; k < compr_col_A->n; k++){
 
 			for(p = compr_col_A ->p[k]; p < compr_col_A->p[k+1];p++){
-				if( k==compr_col_A->i[p]){
+				if( (k==compr_col_A->i[p]) && (compr_col_A->x[p] != 0) ){
 					gsl_vector_set(gsl_M_array,k,compr_col_A->x[p]);
 				}
 			}
@@ -160,8 +366,34 @@ void initialise_iter_methods() {
 			printf("M_array[%d] = %lf\n",k,gsl_vector_get(gsl_M_array,k));
 		}
 
+		// the incomplete factorization is computed once per MNA array and
+		// reused by every DC sweep point and time step
+		// a failure only affects this array, the next one tries the option again
+		active_precond = precond_type;
+		if (precond_type == ILU0_PRECOND) {
+			if (ilu0_init(compr_col_A) == 0) {
+				printf(YEL "Warning" NRM ": Zero pivot in ILU(0). Using the Jacobi preconditioner\n");
+				active_precond = JACOBI_PRECOND;
+			}
+		}
+		else if (precond_type == AMG_PRECOND) {
+			amg_status = amg_init(compr_col_A);
+			if (amg_status != AMG_OK) {
+				if (amg_status == AMG_BAD_DIAG)
+					printf(YEL "Warning" NRM ": AMG requires a positive diagonal. Using the Jacobi preconditioner\n");
+				else
+					printf(YEL "Warning" NRM ": AMG coarsest level cannot be factored. Using the Jacobi preconditioner\n");
+				active_precond = JACOBI_PRECOND;
+			}
+		}
+
 	}
 	else {
+		if (precond_type != JACOBI_PRECOND) {
+			printf(YEL "Warning" NRM ": %s requires sparse matrices. Using the Jacobi preconditioner\n",
+					(precond_type == ILU0_PRECOND)?"ILU(0)":"AMG");
+		}
+		active_precond = JACOBI_PRECOND;
 
 		gsl_mna_array = gsl_matrix_view_array(mna_array, mna_dimension_size, mna_dimension_size);
 		gsl_mna_vector = gsl_vector_view_array(mna_vector, mna_dimension_size);
@@ -186,7 +418,8 @@ void initialise_iter_methods() {
 	gsl_p_vector = gsl_vector_calloc(mna_dimension_size);
 	gsl_q_vector = gsl_vector_calloc(mna_dimension_size);
 
-	if(solver_type == BI_CG_SOLVER) {
+	// BiCGSTAB uses the same four extra vectors as Bi-CG
+	if((solver_type == BI_CG_SOLVER) || (solver_type == BICGSTAB_SOLVER)) {
 		gsl_zT_vector = gsl_vector_calloc(mna_dimension_size);
 		gsl_rT_vector = gsl_vector_calloc(mna_dimension_size);
 		gsl_pT_vector = gsl_vector_calloc(mna_dimension_size);
@@ -210,8 +443,8 @@ void solve_lu() {
 		}
 
 		cs_ipvec(csn_N->pinv, mna_vector, x, mna_dimension_size);
-		cs_lsolve(csn_N->L, x);
-		cs_usolve(csn_N->U, x);
+		tri_solve(tri_L, x);
+		tri_solve(tri_U, x);
 		cs_ipvec(css_S->q, x, mna_vector, mna_dimension_size);
 
 		// mna_vector will contain the solution
@@ -250,8 +483,8 @@ void solve_cholesky() {
 		}
 
 		cs_ipvec(css_S->pinv, mna_vector, x, mna_dimension_size);
-		cs_lsolve(csn_N->L, x);
-		cs_ltsolve(csn_N->L, x);
+		tri_solve(tri_L, x);
+		tri_solve(tri_U, x);
 		cs_pvec(css_S->pinv, x, mna_vector, mna_dimension_size);
 
 		// mna_vector will contain the solution
@@ -276,54 +509,73 @@ void solve_cholesky() {
 
 
 
+// solves the first k right-hand sides of block_B into block_X with a single
+// pass over the sparse LU factors
+void solve_lu_block(int k) {
+
+	cs_ipvec_block(csn_N->pinv, block_B, block_R, mna_dimension_size, k);
+	cs_lsolve_block(csn_N->L, block_R, k);
+	cs_usolve_block(csn_N->U, block_R, k);
+	cs_ipvec_block(css_S->q, block_R, block_X, mna_dimension_size, k);
+}
+
+
+// solves the first k right-hand sides of block_B into block_X with a single
+// pass over the sparse Cholesky factor
+void solve_cholesky_block(int k) {
+
+	cs_ipvec_block(css_S->pinv, block_B, block_R, mna_dimension_size, k);
+	cs_lsolve_block(csn_N->L, block_R, k);
+	cs_ltsolve_block(csn_N->L, block_R, k);
+	cs_pvec_block(css_S->pinv, block_R, block_X, mna_dimension_size, k);
+}
+
+
+
 void solve_CG_iter_method() {
 	unsigned long i;
+	unsigned long n = mna_dimension_size;
 	unsigned int iter;
 	double normR = 0.0, normB = 0.0;
 	double alpha = 0.0, beta = 0.0, tmp = 0.0;
 	double rho = 0.0, rho1 = 0.0;
 
-	gsl_vector_set_zero(gsl_x_vector);
+	// warm start: x keeps the solution of the previous sweep point or time step
+	// r = b - Ax
+	init_iter_residual();
 
-	//r = b
-	gsl_vector_memcpy(gsl_r_vector, &gsl_mna_vector.vector);
-
-	//r = r - Ax
-	// our current initial x is zero so r=r
-	/*gsl_blas_dgemv(CblasNoTrans, -1.0, &gsl_mna_array.matrix, gsl_x_vector, 1.0, gsl_r_vector);*/
+	normB = sqrt(vec_dot(n, gsl_mna_vector.vector.data, gsl_mna_vector.vector.data));
+	if (normB == 0.0)
+		normB = 1.0;
+	normR = sqrt(vec_dot(n, gsl_r_vector->data, gsl_r_vector->data));
 
 	for (iter = 0; iter < MAX(MIN_ITER, mna_dimension_size); iter++) {
-		normR = gsl_blas_dnrm2(gsl_r_vector);
-		normB = gsl_blas_dnrm2(&gsl_mna_vector.vector);
-		if (normB == 0.0)
-			normB = 1.0;
-
 		if ((normR / normB) <= itol)
 			break;
 
-		solve_precond();
-
-		gsl_blas_ddot(gsl_r_vector, gsl_z_vector, &rho);
-
-		if (iter == 0) {
-			gsl_vector_memcpy(gsl_p_vector, gsl_z_vector);
+		// z = M^-1 * r, rho = r . z
+		if (active_precond == JACOBI_PRECOND) {
+			rho = vec_div_dot(n, gsl_r_vector->data, gsl_M_array->data, gsl_z_vector->data);
 		}
 		else {
-			beta = rho / rho1;
-			gsl_vector_scale(gsl_p_vector, beta);
-			gsl_vector_add(gsl_p_vector, gsl_z_vector);
+			solve_precond();
+			rho = vec_dot(n, gsl_r_vector->data, gsl_z_vector->data);
 		}
 
+		// p = z + beta*p
+		beta = (iter == 0)? 0.0 : rho / rho1;
+		vec_xpby(n, gsl_z_vector->data, beta, gsl_p_vector->data);
+
 		rho1 = rho;
 
 		solve_q();
 
-		gsl_blas_ddot(gsl_p_vector, gsl_q_vector, &tmp);
+		tmp = vec_dot(n, gsl_p_vector->data, gsl_q_vector->data);
 		alpha = rho / tmp;
 
-
-		gsl_blas_daxpy(alpha, gsl_p_vector, gsl_x_vector);
-		gsl_blas_daxpy((0.0 - alpha), gsl_q_vector, gsl_r_vector);
+		// x = x + alpha*p, r = r - alpha*q
+		normR = sqrt(vec_cg_update(n, alpha, gsl_p_vector->data, gsl_q_vector->data,
+								   gsl_x_vector->data, gsl_r_vector->data));
 	}
 
 	for (i=1; i < total_ids; i++) {
@@ -336,6 +588,7 @@ void solve_CG_iter_method() {
 
 void solve_BI_CG_iter_method() {
 	unsigned long i;
+	unsigned long n = mna_dimension_size;
 	unsigned int iter;
 	double normR = 0.0, normB = 0.0;
 	double alpha = 0.0, beta = 0.0, omega = 0.0;
@@ -343,48 +596,36 @@ void solve_BI_CG_iter_method() {
 
 
 
-	gsl_vector_set_zero(gsl_x_vector);
-	//r = b
-	gsl_vector_memcpy(gsl_r_vector, &gsl_mna_vector.vector);
-
-	//r = r - Ax
-	// our current initial x is zero so r=r
-	/*gsl_blas_dgemv(CblasNoTrans, -1.0, &gsl_mna_array.matrix, gsl_x_vector, 1.0, gsl_r_vector);*/
+	// warm start: x keeps the solution of the previous sweep point or time step
+	// r = b - Ax
+	init_iter_residual();
 
 	//rT = r
 	gsl_vector_memcpy(gsl_rT_vector, gsl_r_vector);
 
-	for (iter = 0; iter < MAX(MIN_ITER, mna_dimension_size) ; iter++) {
-		normR = gsl_blas_dnrm2(gsl_r_vector);
-		normB = gsl_blas_dnrm2(&gsl_mna_vector.vector);
-		if (normB == 0.0)
-			normB = 1.0;
+	normB = sqrt(vec_dot(n, gsl_mna_vector.vector.data, gsl_mna_vector.vector.data));
+	if (normB == 0.0)
+		normB = 1.0;
+	normR = sqrt(vec_dot(n, gsl_r_vector->data, gsl_r_vector->data));
 
+	for (iter = 0; iter < MAX(MIN_ITER, mna_dimension_size) ; iter++) {
 		if ((normR / normB) <= itol)
 			break;
 
 		solve_precond();	                              // M*z = r
 		Transpose_solve_precond();						  // M(T)*zT = rT
 
-		gsl_blas_ddot(gsl_rT_vector, gsl_z_vector, &rho); //rho = rT . z
+		rho = vec_dot(n, gsl_rT_vector->data, gsl_z_vector->data); //rho = rT . z
 
 		if(fabs(rho) < EPS_DEFAULT){
-			printf(RED" 1) i : %d , Bi-CG failed\n"NRM,iter);
-			exit(EXIT_FAILURE);
-		}
-
-		if (iter == 0) {
-			gsl_vector_memcpy(gsl_p_vector, gsl_z_vector);  // p = z
-			gsl_vector_memcpy(gsl_pT_vector, gsl_zT_vector);  // pT = zT
+			printf(YEL "Warning" NRM ": Bi-CG breakdown (rho) at iteration %d. Switching to GMRES\n", iter);
+			solve_GMRES_iter_method();
+			return;
 		}
-		else {
-			beta = rho / rho1;
-			gsl_vector_scale(gsl_p_vector, beta);        // p = p*beta
-			gsl_vector_add(gsl_p_vector, gsl_z_vector);	 // p = p +z
 
-			gsl_vector_scale(gsl_pT_vector, beta);		 // pT = pT*beta
-			gsl_vector_add(gsl_pT_vector, gsl_zT_vector); // pT = pT +zT
-		}
+		beta = (iter == 0)? 0.0 : rho / rho1;
+		vec_xpby(n, gsl_z_vector->data, beta, gsl_p_vector->data);		// p = z + beta*p
+		vec_xpby(n, gsl_zT_vector->data, beta, gsl_pT_vector->data);	// pT = zT + beta*pT
 
 		rho1 = rho;
 
@@ -392,19 +633,21 @@ void solve_BI_CG_iter_method() {
 
 		Transpose_solve_q();					// qT = A(T) . pT
 
-		gsl_blas_ddot(gsl_pT_vector, gsl_q_vector, &omega);    // omega = pT . q
+		omega = vec_dot(n, gsl_pT_vector->data, gsl_q_vector->data);    // omega = pT . q
 
 		/*printf("OMEGA = %lf\n", omega);*/
 		if(fabs(omega) < EPS_DEFAULT){
-			printf(RED" 2) i : %d , Bi-CG failed\n"NRM,iter);
-			exit(EXIT_FAILURE);
+			printf(YEL "Warning" NRM ": Bi-CG breakdown (omega) at iteration %d. Switching to GMRES\n", iter);
+			solve_GMRES_iter_method();
+			return;
 		}
 
 		alpha = rho/omega;
 
-		gsl_blas_daxpy(alpha, gsl_p_vector, gsl_x_vector);			 // x = x + alpha*p
-		gsl_blas_daxpy((0.0 - alpha), gsl_q_vector, gsl_r_vector);   // r = r -alpha*q
-		gsl_blas_daxpy((0.0 - alpha), gsl_qT_vector, gsl_rT_vector); // rT = rT -alpha*qT
+		// x = x + alpha*p, r = r - alpha*q
+		normR = sqrt(vec_cg_update(n, alpha, gsl_p_vector->data, gsl_q_vector->data,
+								   gsl_x_vector->data, gsl_r_vector->data));
+		vec_axpy(n, (0.0 - alpha), gsl_qT_vector->data, gsl_rT_vector->data); // rT = rT -alpha*qT
 	}
 
 	for (i=1; i < total_ids; i++) {
@@ -414,79 +657,586 @@ void solve_BI_CG_iter_method() {
 
 }
 
-void solve_precond() {
-	gsl_vector_memcpy(gsl_z_vector,gsl_r_vector);
-	gsl_vector_div(gsl_z_vector, gsl_M_array);
+// BiCGSTAB with right preconditioning. It needs no products with A' and
+// restarts from the true residual on breakdown. After BICGSTAB_MAX_RESTARTS
+// breakdowns the system is handed to GMRES, which cannot break down.
+// Vectors: p, v = q, p_hat = z, s_hat = zT, r_hat = rT, s = pT, t = qT
+void solve_BICGSTAB_iter_method() {
+	unsigned long i;
+	unsigned long n = mna_dimension_size;
+	unsigned int iter, restarts = 0;
+	double normR = 0.0, normB = 0.0, normR_hat = 0.0, normS = 0.0;
+	double alpha = 0.0, beta = 0.0, omega = 0.0, tmp = 0.0;
+	double rho = 0.0, rho1 = 0.0;
+	byte restart = 1, breakdown = 0;
+	double *x = gsl_x_vector->data;
+	double *r = gsl_r_vector->data;
+	double *r_hat = gsl_rT_vector->data;
+	double *p = gsl_p_vector->data;
+	double *v = gsl_q_vector->data;
+	double *p_hat = gsl_z_vector->data;
+	double *s_hat = gsl_zT_vector->data;
+	double *s = gsl_pT_vector->data;
+	double *t = gsl_qT_vector->data;
+
+	// warm start: x keeps the solution of the previous sweep point or time step
+	// r = b - Ax
+	init_iter_residual();
+
+	normB = sqrt(vec_dot(n, gsl_mna_vector.vector.data, gsl_mna_vector.vector.data));
+	if (normB == 0.0)
+		normB = 1.0;
+	normR = sqrt(vec_dot(n, r, r));
+
+	for (iter = 0; iter < MAX(MIN_ITER, mna_dimension_size); iter++) {
+		if ((normR / normB) <= itol)
+			break;
+
+		if (breakdown) {
+			restarts++;
+			if (restarts > BICGSTAB_MAX_RESTARTS) {
+				printf(YEL "Warning" NRM ": BiCGSTAB breakdown at iteration %d. Switching to GMRES\n", iter);
+				solve_GMRES_iter_method();
+				return;
+			}
+
+			// restart from the true residual
+			init_iter_residual();
+			normR = sqrt(vec_dot(n, r, r));
+			breakdown = 0;
+			restart = 1;
+			continue;
+		}
+
+		// the shadow residual is (re)set to the current residual
+		if (restart) {
+			memcpy(r_hat, r, n*sizeof(double));
+			normR_hat = normR;
+		}
+
+		rho = vec_dot(n, r_hat, r);		// rho = r_hat . r
+		if (fabs(rho) <= EPS_DEFAULT * normR_hat * normR) {
+			breakdown = 1;
+			continue;
+		}
+
+		if (restart) {
+			memcpy(p, r, n*sizeof(double));	// p = r
+			restart = 0;
+		}
+		else {
+			// p = r + beta*(p - omega*v)
+			beta = (rho / rho1) * (alpha / omega);
+			vec_axpy(n, (0.0 - omega), v, p);
+			vec_xpby(n, r, beta, p);
+		}
+
+		apply_precond(p, p_hat);		// M*p_hat = p
+		mna_spmv(p_hat, v);				// v = A . p_hat
+
+		tmp = vec_dot(n, r_hat, v);
+		alpha = rho / tmp;
+		if ((tmp == 0.0) || (!isfinite(alpha))) {
+			breakdown = 1;
+			continue;
+		}
+
+		// s = r - alpha*v
+		normS = sqrt(vec_waxpy_dot(n, (0.0 - alpha), v, r, s));
+		if ((normS / normB) <= itol) {
+			vec_axpy(n, alpha, p_hat, x);
+			break;
+		}
+
+		apply_precond(s, s_hat);		// M*s_hat = s
+		mna_spmv(s_hat, t);				// t = A . s_hat
+
+		tmp = vec_dot(n, t, t);
+		if (tmp == 0.0) {
+			// keep the half step and restart
+			vec_axpy(n, alpha, p_hat, x);
+			breakdown = 1;
+			continue;
+		}
+		omega = vec_dot(n, t, s) / tmp;
+
+		// x = x + alpha*p_hat + omega*s_hat, r = s - omega*t
+		vec_axpy(n, alpha, p_hat, x);
+		vec_axpy(n, omega, s_hat, x);
+		normR = sqrt(vec_waxpy_dot(n, (0.0 - omega), t, s, r));
+
+		// stagnation, the next direction would divide by omega
+		if (omega == 0.0)
+			breakdown = 1;
+
+		rho1 = rho;
+	}
+
+	for (i=1; i < total_ids; i++) {
+		id_to_node[i]->val = gsl_vector_get(gsl_x_vector, i-1);
+	}
 }
 
-// q = A.p
-void solve_q() {
 
+// allocates the GMRES(m) workspace the first time GMRES runs
+void gmres_alloc() {
+	unsigned long m = gmres_restart;
+
+	if (gmres_V != NULL)
+		return;
+
+	gmres_V = (double *) malloc((m+1)*mna_dimension_size*sizeof(double));
+	gmres_H = (double *) malloc((m+1)*m*sizeof(double));
+	gmres_c = (double *) malloc(m*sizeof(double));
+	gmres_s = (double *) malloc(m*sizeof(double));
+	gmres_g = (double *) malloc((m+1)*sizeof(double));
+	gmres_y = (double *) malloc(m*sizeof(double));
+	if ((gmres_V == NULL) || (gmres_H == NULL) || (gmres_c == NULL) ||
+		(gmres_s == NULL) || (gmres_g == NULL) || (gmres_y == NULL)) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+void gmres_free() {
+	free(gmres_V);
+	gmres_V = NULL;
+	free(gmres_H);
+	gmres_H = NULL;
+	free(gmres_c);
+	gmres_c = NULL;
+	free(gmres_s);
+	gmres_s = NULL;
+	free(gmres_g);
+	gmres_g = NULL;
+	free(gmres_y);
+	gmres_y = NULL;
+}
+
+
+// restarted GMRES(m) with right preconditioning. The residual norm of the
+// least squares problem is known at every step without forming x, which is
+// only updated at the end of each cycle: x = x + M^-1 * V*y
+void solve_GMRES_iter_method() {
 	unsigned long i;
+	unsigned long n = mna_dimension_size;
+	unsigned int iter = 0;
+	int j, k, m, ld;
+	double normR = 0.0, normB = 0.0;
+	double h = 0.0, tmp = 0.0;
+	double *V, *H, *w;
+
+	gmres_alloc();
+	m = gmres_restart;
+	ld = m + 1;
+	V = gmres_V;
+	H = gmres_H;
+
+	normB = sqrt(vec_dot(n, gsl_mna_vector.vector.data, gsl_mna_vector.vector.data));
+	if (normB == 0.0)
+		normB = 1.0;
+
+	while (iter < MAX(MIN_ITER, mna_dimension_size)) {
+		// warm start: x keeps the solution of the previous sweep point or time step
+		// r = b - Ax
+		init_iter_residual();
+		normR = sqrt(vec_dot(n, gsl_r_vector->data, gsl_r_vector->data));
+		if ((normR / normB) <= itol)
+			break;
 
-	if(is_sparse) {
+		// v0 = r / |r|
+		vec_scale(n, 1.0 / normR, gsl_r_vector->data, V);
+		memset(gmres_g, 0, ld*sizeof(double));
+		gmres_g[0] = normR;
+
+		for (j = 0; j < m; ) {
+			w = &V[(j+1)*n];
+
+			// w = A * M^-1 * v_j
+			apply_precond(&V[j*n], gsl_z_vector->data);
+			mna_spmv(gsl_z_vector->data, w);
+
+			// modified Gram-Schmidt
+			for (k = 0; k <= j; k++) {
+				h = vec_dot(n, w, &V[k*n]);
+				H[k + j*ld] = h;
+				vec_axpy(n, (0.0 - h), &V[k*n], w);
+			}
+			h = sqrt(vec_dot(n, w, w));
+			H[j+1 + j*ld] = h;
+			if (h != 0.0)
+				vec_scale(n, 1.0 / h, w, w);
+
+			// apply the previous rotations to the new column
+			for (k = 0; k < j; k++) {
+				tmp = gmres_c[k]*H[k + j*ld] + gmres_s[k]*H[k+1 + j*ld];
+				H[k+1 + j*ld] = gmres_c[k]*H[k+1 + j*ld] - gmres_s[k]*H[k + j*ld];
+				H[k + j*ld] = tmp;
+			}
 
-		for( i=0; i<mna_dimension_size; i++){
-			p_vector[i] = gsl_vector_get(gsl_p_vector, i);
+			// new rotation zeroes H[j+1][j]. A zero column means A*M^-1 is
+			// singular on the basis: stop the cycle without it
+			tmp = hypot(H[j + j*ld], H[j+1 + j*ld]);
+			if (tmp == 0.0)
+				break;
+			gmres_c[j] = H[j + j*ld] / tmp;
+			gmres_s[j] = H[j+1 + j*ld] / tmp;
+			H[j + j*ld] = tmp;
+			H[j+1 + j*ld] = 0.0;
+			gmres_g[j+1] = (0.0 - gmres_s[j]) * gmres_g[j];
+			gmres_g[j] = gmres_c[j] * gmres_g[j];
+
+			j++;
+			iter++;
+
+			// |g[j]| is the residual norm. h == 0 is the lucky breakdown: x is exact
+			if (((fabs(gmres_g[j]) / normB) <= itol) || (h == 0.0) ||
+				(iter >= MAX(MIN_ITER, mna_dimension_size)))
+				break;
 		}
 
-		// q must be zero so that q = A.p + q = A.p
-		cs_gaxpy(compr_col_A,p_vector,q_vector);
+		// no progress possible
+		if (j == 0) {
+			printf(YEL "Warning" NRM ": GMRES stagnated at iteration %d\n", iter);
+			break;
+		}
 
-		for( i=0; i<mna_dimension_size; i++){
-			gsl_vector_set(gsl_q_vector,i,q_vector[i]);
+		// y = H^-1 * g (upper triangular)
+		for (k = j - 1; k >= 0; k--) {
+			tmp = gmres_g[k];
+			for (i = k + 1; i < j; i++)
+				tmp -= H[k + i*ld] * gmres_y[i];
+			gmres_y[k] = tmp / H[k + k*ld];
 		}
 
-		// restore q
-		memset(q_vector, 0, mna_dimension_size*sizeof(double));
+		// x = x + M^-1 * (V*y)
+		memset(gsl_p_vector->data, 0, n*sizeof(double));
+		for (k = 0; k < j; k++)
+			vec_axpy(n, gmres_y[k], &V[k*n], gsl_p_vector->data);
+		apply_precond(gsl_p_vector->data, gsl_z_vector->data);
+		vec_axpy(n, 1.0, gsl_z_vector->data, gsl_x_vector->data);
+	}
 
+	for (i=1; i < total_ids; i++) {
+		id_to_node[i]->val = gsl_vector_get(gsl_x_vector, i-1);
+	}
+}
+
+
+// Y = A*X for k vectors stored by rows
+void mna_spmm(int k, const double *X, double *Y) {
+	gsl_matrix_view X_view, Y_view;
+
+	if (is_sparse) {
+		// A' = A for the symmetric arrays of CG
+		if (compr_col_AT)
+			spmm_transpose(compr_col_AT, k, X, Y);
+		else
+			spmm_transpose(compr_col_A, k, X, Y);
 	}
 	else {
-		gsl_blas_dgemv(CblasNoTrans, 1.0, &gsl_mna_array.matrix, gsl_p_vector, 0.0, gsl_q_vector);
+		X_view = gsl_matrix_view_array((double *) X, mna_dimension_size, k);
+		Y_view = gsl_matrix_view_array(Y, mna_dimension_size, k);
+		gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &gsl_mna_array.matrix, &X_view.matrix,
+					   0.0, &Y_view.matrix);
 	}
+}
 
 
-	// DEBUG
-	/*printf("solve_q (%s)\n", is_sparse?"sparse":"not sparse");*/
-	/*for (i=0; i < mna_dimension_size; i++) {*/
-		/*printf("q[%lu] = %lf\n", i, gsl_vector_get(gsl_q_vector, i));*/
-	/*}*/
+// CG on the first k columns of block_B at the same time. Every column keeps
+// its own step lengths, but the products with A are done for all of them in
+// one pass over the array. A column stops being updated once it converges
+void solve_block_CG_iter_method(int k) {
+	unsigned long i;
+	unsigned long n = mna_dimension_size;
+	unsigned int iter;
+	int c, active;
+	double normB[DC_BLOCK_SIZE], normR[DC_BLOCK_SIZE];
+	double alpha[DC_BLOCK_SIZE], beta[DC_BLOCK_SIZE], tmp[DC_BLOCK_SIZE];
+	double rho[DC_BLOCK_SIZE], rho1[DC_BLOCK_SIZE];
+	byte converged[DC_BLOCK_SIZE];
+
+	// R = B - A*X
+	mna_spmm(k, block_X, block_Q);
+	vec_waxpy_dot(n*k, -1.0, block_Q, block_B, block_R);
+
+	vec_block_dot(n, k, block_B, block_B, normB);
+	vec_block_dot(n, k, block_R, block_R, normR);
+	for (c = 0; c < k; c++) {
+		normB[c] = sqrt(normB[c]);
+		if (normB[c] == 0.0)
+			normB[c] = 1.0;
+		normR[c] = sqrt(normR[c]);
+		converged[c] = 0;
+	}
+
+	for (iter = 0; iter < MAX(MIN_ITER, mna_dimension_size); iter++) {
+		active = 0;
+		for (c = 0; c < k; c++) {
+			if ((normR[c] / normB[c]) <= itol)
+				converged[c] = 1;
+			if (!converged[c])
+				active++;
+		}
+		if (active == 0)
+			break;
+
+		// Z = M^-1 * R
+		if (active_precond == JACOBI_PRECOND) {
+			for (i = 0; i < n; i++) {
+				for (c = 0; c < k; c++)
+					block_Z[i*k + c] = block_R[i*k + c] / gsl_M_array->data[i];
+			}
+		}
+		else {
+			for (c = 0; c < k; c++) {
+				if (converged[c])
+					continue;
+				for (i = 0; i < n; i++)
+					gsl_r_vector->data[i] = block_R[i*k + c];
+				apply_precond(gsl_r_vector->data, gsl_z_vector->data);
+				for (i = 0; i < n; i++)
+					block_Z[i*k + c] = gsl_z_vector->data[i];
+			}
+		}
+
+		vec_block_dot(n, k, block_R, block_Z, rho);
+
+		// P = Z + beta*P
+		for (c = 0; c < k; c++)
+			beta[c] = ((iter == 0) || converged[c])? 0.0 : rho[c] / rho1[c];
+		vec_block_xpby(n, k, block_Z, beta, block_P);
+
+		for (c = 0; c < k; c++)
+			rho1[c] = rho[c];
+
+		mna_spmm(k, block_P, block_Q);
+
+		// X = X + alpha*P, R = R - alpha*Q
+		vec_block_dot(n, k, block_P, block_Q, tmp);
+		for (c = 0; c < k; c++)
+			alpha[c] = converged[c]? 0.0 : rho[c] / tmp[c];
+		vec_block_cg_update(n, k, alpha, block_P, block_Q, block_X, block_R, normR);
+		for (c = 0; c < k; c++)
+			normR[c] = sqrt(normR[c]);
+	}
 }
 
-void Transpose_solve_precond() {
-	gsl_vector_memcpy(gsl_zT_vector,gsl_rT_vector);
-	gsl_vector_div(gsl_zT_vector, gsl_M_array);        //M_transpose = M
+
+// the sparse direct solvers and CG solve the points of a DC sweep in blocks
+byte dc_block_solver() {
+	if (solver_type == CG_SOLVER)
+		return 1;
+	if ((is_sparse) && ((solver_type == LU_SOLVER) || (solver_type == CHOL_SOLVER)))
+		return 1;
+	return 0;
 }
 
 
-void Transpose_solve_q(){
+// allocates the DC sweep workspace the first time a DC sweep uses it
+void dc_block_alloc() {
+	unsigned long size = mna_dimension_size * DC_BLOCK_SIZE;
 
-	int i,p;
+	if (block_B != NULL)
+		return;
 
-	if(is_sparse) {
+	block_B = (double *) calloc(size, sizeof(double));
+	block_X = (double *) calloc(size, sizeof(double));
+	block_R = (double *) calloc(size, sizeof(double));
+	block_Z = (double *) calloc(size, sizeof(double));
+	block_P = (double *) calloc(size, sizeof(double));
+	block_Q = (double *) calloc(size, sizeof(double));
+	block_x_prev = (double *) malloc(mna_dimension_size*sizeof(double));
+	if ((block_B == NULL) || (block_X == NULL) || (block_R == NULL) ||
+		(block_Z == NULL) || (block_P == NULL) || (block_Q == NULL) || (block_x_prev == NULL)) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	block_len = 0;
+	block_known = 0;
+}
 
-		for( i=0; i<mna_dimension_size; i++){
-			p_vector[i] = gsl_vector_get(gsl_pT_vector, i);
-		}
 
-		// q must be zero so that q = A.p + q = A.p
+void dc_block_free() {
+	free(block_B);
+	block_B = NULL;
+	free(block_X);
+	block_X = NULL;
+	free(block_R);
+	block_R = NULL;
+	free(block_Z);
+	block_Z = NULL;
+	free(block_P);
+	block_P = NULL;
+	free(block_Q);
+	block_Q = NULL;
+	free(block_x_prev);
+	block_x_prev = NULL;
+	block_len = 0;
+	block_known = 0;
+}
+
 
+// queues the current mna_vector of the DC sweep point val. The queue is
+// solved once it holds DC_BLOCK_SIZE right-hand sides
+void dc_block_push(double val, plot_probe *probes, unsigned long probes_num) {
+	unsigned long i;
+
+	dc_block_alloc();
 
-		for(i = 0; i < compr_col_A->n; i++){
+	for (i = 0; i < mna_dimension_size; i++)
+		block_B[i*DC_BLOCK_SIZE + block_len] = mna_vector[i];
+	block_vals[block_len] = val;
+	block_len++;
+
+	if (block_len == DC_BLOCK_SIZE)
+		dc_block_flush(probes, probes_num, 0);
+}
 
-			for(p = compr_col_A ->p[i]; p < compr_col_A->p[i+1];p++){
 
-				q_vector[i]=q_vector[i]+compr_col_A->x[p]*p_vector[compr_col_A->i[p]];
+// solves the queued DC sweep points and writes the probed nodes of each one.
+// sweep_end is set by the last call of a sweep
+void dc_block_flush(plot_probe *probes, unsigned long probes_num, byte sweep_end) {
+	unsigned long i, k;
+	int c, len = block_len;
+	double slope;
+
+	if (len > 0) {
+		// the columns are packed by DC_BLOCK_SIZE, so a partial block is first
+		// moved to a stride of len
+		if (len < DC_BLOCK_SIZE) {
+			for (i = 0; i < mna_dimension_size; i++) {
+				for (c = 0; c < len; c++)
+					block_B[i*len + c] = block_B[i*DC_BLOCK_SIZE + c];
 			}
 		}
 
-		for( i=0; i<mna_dimension_size; i++){
-			gsl_vector_set(gsl_qT_vector,i,q_vector[i]);
+		if (solver_type == LU_SOLVER) {
+			solve_lu_block(len);
 		}
+		else if (solver_type == CHOL_SOLVER) {
+			solve_cholesky_block(len);
+		}
+		else {
+			// initial guesses on the line through the two last solutions
+			for (i = 0; i < mna_dimension_size; i++) {
+				slope = 0.0;
+				if (block_known >= 2)
+					slope = (gsl_x_vector->data[i] - block_x_prev[i]) / (block_val_last - block_val_prev);
+				for (c = 0; c < len; c++)
+					block_X[i*len + c] = gsl_x_vector->data[i] + (block_vals[c] - block_val_last) * slope;
+			}
+
+			solve_block_CG_iter_method(len);
+		}
+
+		for (c = 0; c < len; c++) {
+			for (i=1; i < total_ids; i++) {
+				id_to_node[i]->val = block_X[(i-1)*len + c];
+			}
+			for (k = 0; k < probes_num; k++) {
+				fprintf(probes[k].fp, "%lf\t\t%e\n", block_vals[c], probes[k].node->val);
+			}
+		}
+
+		// the next CG block starts from the last sweep point
+		if (solver_type == CG_SOLVER) {
+			for (i = 0; i < mna_dimension_size; i++) {
+				block_x_prev[i] = (len > 1)? block_X[i*len + len - 2] : gsl_x_vector->data[i];
+				gsl_x_vector->data[i] = block_X[i*len + len - 1];
+			}
+			block_val_prev = (len > 1)? block_vals[len-2] : block_val_last;
+			block_val_last = block_vals[len-1];
+			block_known = MIN(block_known + len, 2);
+		}
+		block_len = 0;
+	}
+
+	if (sweep_end)
+		block_known = 0;
+}
+
+
+// r = b - A*x for the initial guess of the iterative methods
+void init_iter_residual() {
+
+	gsl_vector_memcpy(gsl_r_vector, &gsl_mna_vector.vector);
+
+	if (is_sparse) {
+		// A' = A for the symmetric arrays of CG
+		if (compr_col_AT)
+			spmv_transpose(compr_col_AT, -1.0, gsl_x_vector->data, 1.0, gsl_r_vector->data);
+		else
+			spmv_transpose(compr_col_A, -1.0, gsl_x_vector->data, 1.0, gsl_r_vector->data);
+	}
+	else {
+		gsl_blas_dgemv(CblasNoTrans, -1.0, &gsl_mna_array.matrix, gsl_x_vector, 1.0, gsl_r_vector);
+	}
+}
+
+// z = M^-1 * r
+void apply_precond(const double *r, double *z) {
+	if (active_precond == ILU0_PRECOND) {
+		ilu0_solve(r, z);
+		return;
+	}
+	if (active_precond == AMG_PRECOND) {
+		amg_solve(r, z);
+		return;
+	}
+
+	vec_div_dot(mna_dimension_size, r, gsl_M_array->data, z);
+}
+
+void solve_precond() {
+	apply_precond(gsl_r_vector->data, gsl_z_vector->data);
+}
+
+// y = A.x
+void mna_spmv(const double *x, double *y) {
+	gsl_vector_view x_view, y_view;
+
+	if(is_sparse) {
+		// A' = A for the symmetric arrays of CG
+		if (compr_col_AT)
+			spmv_transpose(compr_col_AT, 1.0, x, 0.0, y);
+		else
+			spmv_transpose(compr_col_A, 1.0, x, 0.0, y);
+	}
+	else {
+		x_view = gsl_vector_view_array((double *) x, mna_dimension_size);
+		y_view = gsl_vector_view_array(y, mna_dimension_size);
+		gsl_blas_dgemv(CblasNoTrans, 1.0, &gsl_mna_array.matrix, &x_view.vector, 0.0, &y_view.vector);
+	}
+}
 
-		// restore q
-		memset(q_vector, 0, mna_dimension_size*sizeof(double));
+// q = A.p
+void solve_q() {
+	mna_spmv(gsl_p_vector->data, gsl_q_vector->data);
+}
 
+void Transpose_solve_precond() {
+	if (active_precond == ILU0_PRECOND) {
+		ilu0_transpose_solve(gsl_rT_vector->data, gsl_zT_vector->data);
+		return;
+	}
+	// the V-cycle is symmetric for the symmetric arrays AMG is meant for
+	if (active_precond == AMG_PRECOND) {
+		amg_solve(gsl_rT_vector->data, gsl_zT_vector->data);
+		return;
+	}
+
+	//M_transpose = M
+	vec_div_dot(mna_dimension_size, gsl_rT_vector->data, gsl_M_array->data, gsl_zT_vector->data);
+}
+
+
+void Transpose_solve_q(){
+
+	if(is_sparse) {
+		// qT = A'.pT
+		spmv_transpose(compr_col_A, 1.0, gsl_pT_vector->data, 0.0, gsl_qT_vector->data);
 	}
 	else {
 		gsl_blas_dgemv(CblasTrans, 1.0, &gsl_mna_array.matrix, gsl_pT_vector, 0.0, gsl_qT_vector);
@@ -632,24 +1382,137 @@ double get_pwl_val(PwlInfoT *data, double t) {
 }
 
 
+// parses the consecutive .PLOT/.PRINT commands starting from command_list[*cmd_idx] and
+// returns an array with the probed nodes, so that a single analysis run can write all of them.
+// On return *cmd_idx is the index of the last plot command parsed
+plot_probe *parse_probes(unsigned long *cmd_idx, unsigned long *probes_num) {
+	const char delim[5] = " \r\t\n";
+	char *token = NULL;
+	char *node_name = NULL;
+	element_h *node = NULL;
+	plot_probe *probes = NULL;
+	unsigned long i, k;
+
+	*probes_num = 0;
+
+	for (i = *cmd_idx; i < command_list_len; i++) {
+		if ((strncmp(command_list[i], ".PRINT ", 7) != 0) && (strncmp(command_list[i], ".PLOT ", 6) != 0))
+			break;
+
+		*cmd_idx = i;
+
+		// bypass command name
+		token = strtok(command_list[i], delim);
+		if (token == NULL) {
+			printf(RED "Error" NRM ": Not enough arguments (%s)\n Bypassing..\n", command_list[i]);
+			continue;
+		}
+
+		// check if the node is written correctly in command (syntax check)
+		token = strtok(NULL, delim);
+		printf("token: %s\n", token);
+		if (token == NULL) {
+			printf(RED "Error" NRM ": Not enough arguments (%s)\n Bypassing..\n", command_list[i]);
+			continue;
+		}
+		if ((toupper(token[0]) != 'V') || (token[1] != '(') || (token[strlen(token)-1] != ')') ) {
+			printf(RED "Error" NRM ": Invalid argument value (%s)\n Bypassing..\n", token);
+			continue;
+		}
+
+		// checks were successsful. store node name into a variable
+		// +1 for '\0', -1 for 'v', -1 for '(' and -1 for ')'
+		node_name = malloc( (strlen(token) - 2)*sizeof(char));
+		if (node_name == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+		snprintf(node_name, strlen(token)-2, "%s", &token[2]);
+
+		// search for the node in the hashtable
+		node = ht_get(node_name);
+		free(node_name);
+		node_name = NULL;
+		if (node == NULL) {
+			printf(RED "Error" NRM ": Node not found (%s)\n Bypassing\n", token);
+			continue;
+		}
+
+		// the name including the parentheses is used only for file name generation
+		node_name = strdup(token);
+		if (node_name == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+
+		// there should be no more arguments (syntax check)
+		token = strtok(NULL, delim);
+		if (token != NULL) {
+			printf(RED "Error" NRM ": Command contains extra false arguments (%s)\n Bypassing\n", command_list[i]);
+			free(node_name);
+			node_name = NULL;
+			continue;
+		}
+
+		// a node probed twice would have its output file opened twice
+		for (k = 0; k < *probes_num; k++) {
+			if (probes[k].node == node)
+				break;
+		}
+		if (k < *probes_num) {
+			printf(YEL "Warning" NRM ": Node already probed (%s)\n Bypassing\n", node_name);
+			free(node_name);
+			node_name = NULL;
+			continue;
+		}
+
+		probes = (plot_probe *) realloc(probes, (*probes_num + 1)*sizeof(plot_probe));
+		if (probes == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+
+		probes[*probes_num].node = node;
+		probes[*probes_num].name = node_name;
+		probes[*probes_num].filename = NULL;
+		probes[*probes_num].fp = NULL;
+		(*probes_num)++;
+
+		node_name = NULL;
+	}
+
+	return probes;
+}
+
+
+// closes the output files of the probes and frees the array
+void free_probes(plot_probe *probes, unsigned long probes_num) {
+	unsigned long i;
+
+	for (i = 0; i < probes_num; i++) {
+		if (probes[i].fp)
+			fclose(probes[i].fp);
+		free(probes[i].filename);
+		free(probes[i].name);
+	}
+	free(probes);
+}
+
+
 // executes the command_list (command .OPTIONS is excluded from the list as it is executed during the parsing phase)
 void execute_commands() {
-	unsigned long i,k,l;
+	unsigned long i,k;
 	const char delim[5] = " \r\t\n";
 	char *token = NULL;
 
 	// variables used for DC command
 	FILE *fp_draw = NULL;
-	FILE *node_fp = NULL;
 	char *var_name = NULL;
-	char *node_name = NULL;
-	char *filename = NULL;
 	double j = 0;
 	double start = 0;
 	double end = 0;
 	double jump = 0;
 	byte var_found = 0; // 0 if not found, 1 if found in list1, 2 if found in list2
-	element_h *node = NULL;
 	unsigned long idx1;
 	unsigned long idx2;
 	list_element *var = NULL;
@@ -660,6 +1523,10 @@ void execute_commands() {
 	double trans_value;
 	double (*get_func_ptr)(void *, double);
 
+	// nodes probed by the plot commands that follow a .DC or .TRAN
+	plot_probe *probes = NULL;
+	unsigned long probes_num = 0;
+
 
 	// this is a global variable that indicates the length list that contains
 	// the commands to be executed. Therefore in this case there are no commands
@@ -822,91 +1689,28 @@ void execute_commands() {
 				continue;
 			}
 
-			// bypass command name
-			token = strtok(command_list[i], delim);
-			if (token == NULL) {
-				printf(RED "Error" NRM ": Not enough arguments (%s)\n Bypassing..\n", command_list[i]);
-				free(var_name);
-				var_name = NULL;
+			// gather all the subsequent plot commands so that each sweep point
+			// is solved only once and written to every probed node
+			probes = parse_probes(&i, &probes_num);
+			if (probes_num == 0)
 				continue;
-			}
 
-			// check if the node is written correctly in command (syntax check)
-			token = strtok(NULL, delim);
-			printf("token: %s\n", token);
-			if (token == NULL) {
-				printf(RED "Error" NRM ": Not enough arguments (%s)\n Bypassing..\n", command_list[i]);
-				free(var_name);
-				var_name = NULL;
-				continue;
-			}
-			if ((toupper(token[0]) != 'V') || (token[1] != '(') || (token[strlen(token)-1] != ')') ) {
-				printf(RED "Error" NRM ": Invalid argument value (%s)\n Bypassing..\n", token);
-				free(var_name);
-				var_name = NULL;
-				continue;
-			}
-
-			// checks were successsful. store node name into a variable
-			// +1 for '\0', -1 for 'v', -1 for '(' and -1 for ')'
-			node_name = malloc( (strlen(token) - 2)*sizeof(char));
-			if (node_name == NULL) {
-				printf("Error. Memory allocation problems. Exiting..\n");
-				exit(EXIT_FAILURE);
-			}
-			snprintf(node_name, strlen(token)-2, "%s", &token[2]);
-
-
-			// search for the node in the hashtable
-			node = ht_get(node_name);
-			if (node == NULL) {
-				printf(RED "Error" NRM ": Node not found (%s)\n Bypassing\n", token);
-				free(var_name);
-				free(node_name);
-				var_name = NULL;
-				node_name = NULL;
-				continue;
-			}
-
-			/***********/
-			// now that we have successfully located the node in the hash table and aquired
-			// its pointer we are rereading the name including the parantheses. This is used only for
-			// file name generation
-			node_name = realloc(node_name,(strlen(token)+1)*sizeof(char));
-			if (node_name == NULL) {
-				printf("Error. Memory allocation problems. Exiting..\n");
-				exit(EXIT_FAILURE);
-			}
-			snprintf(node_name, strlen(token)+1, "%s", &token[0]);
-			/***********/
-
-
-			// there should be no more arguments (syntax check)
-			token = strtok(NULL, delim);
-			if (token != NULL) {
-				printf(RED "Error" NRM ": Command contains extra false arguments (%s)\n Bypassing\n", command_list[i]);
-				free(var_name);
-				free(node_name);
-				var_name = NULL;
-				node_name = NULL;
-				continue;
-			}
-
-
-			// reminder: variable var_name is the I or V that changes value during the DC or TRAN analysis
-			// strlen(node_name) +9 = strlen(node_name) + strlen("_DC_") + strlen(".txt") + 1 for '\0'
-			filename = (char *) malloc((strlen(var_name) + strlen(node_name) + 9)*sizeof(char));
-			if (filename == NULL) {
-				printf("Error. Memory allocation problems. Exiting..\n");
-				exit(EXIT_FAILURE);
-			}
+			for (k = 0; k < probes_num; k++) {
+				// reminder: variable var_name is the I or V that changes value during the DC or TRAN analysis
+				// strlen(name) + 9 = strlen(name) + strlen("_DC_") + strlen(".txt") + 1 for '\0'
+				probes[k].filename = (char *) malloc((strlen(var_name) + strlen(probes[k].name) + 9)*sizeof(char));
+				if (probes[k].filename == NULL) {
+					printf("Error. Memory allocation problems. Exiting..\n");
+					exit(EXIT_FAILURE);
+				}
 
-			sprintf(filename, "%s_DC_%s.txt", node_name, var_name);
+				sprintf(probes[k].filename, "%s_DC_%s.txt", probes[k].name, var_name);
 
-			node_fp = fopen(filename, "w");
-			if (node_fp == NULL) {
-				perror("fopen");
-				exit(EXIT_FAILURE);
+				probes[k].fp = fopen(probes[k].filename, "w");
+				if (probes[k].fp == NULL) {
+					perror("fopen");
+					exit(EXIT_FAILURE);
+				}
 			}
 
 
@@ -924,13 +1728,6 @@ void execute_commands() {
 				// it is guaranteed that at this point is_trans is set to 1
 				reset_MNA_array();
 
-				if ((is_sparse) && ((solver_type == LU_SOLVER) || (solver_type == CHOL_SOLVER))) {
-					if (css_S)
-						cs_sfree(css_S);
-					if (csn_N)
-						cs_nfree(csn_N);
-				}
-
 				// free everything first as the decomposition and initialisation allocations
 				// will be performed again
 
@@ -948,11 +1745,9 @@ void execute_commands() {
 					// iterative solving method. No need to decompose
 					case CG_SOLVER:
 					case BI_CG_SOLVER:
+					case BICGSTAB_SOLVER:
+					case GMRES_SOLVER:
 						free_gsl_vectors();
-						if (p_vector)
-							free(p_vector);
-						if (q_vector)
-							free(q_vector);
 						initialise_iter_methods();
 						break;
 					default:
@@ -982,6 +1777,12 @@ void execute_commands() {
 
 					var->value = j;
 
+					// solve the sweep points DC_BLOCK_SIZE at a time
+					if (dc_block_solver()) {
+						dc_block_push(j, probes, probes_num);
+						continue;
+					}
+
 					switch(solver_type) {
 						case LU_SOLVER:
 							solve_lu();
@@ -989,17 +1790,21 @@ void execute_commands() {
 						case CHOL_SOLVER:
 							solve_cholesky();
 							break;
-						case CG_SOLVER:
-							solve_CG_iter_method();
-							break;
 						case BI_CG_SOLVER:
 							solve_BI_CG_iter_method();
 							break;
+						case BICGSTAB_SOLVER:
+							solve_BICGSTAB_iter_method();
+							break;
+						case GMRES_SOLVER:
+							solve_GMRES_iter_method();
+							break;
 						default:
 							break;
 					}
-					/*fprintf(node_fp, "%lf\t\t%lf\n", j, node->val);*/
-					fprintf(node_fp, "%lf\t\t%e\n", j, node->val);
+					for (k = 0; k < probes_num; k++) {
+						fprintf(probes[k].fp, "%lf\t\t%e\n", j, probes[k].node->val);
+					}
 				}
 
 			}
@@ -1011,6 +1816,12 @@ void execute_commands() {
 					mna_vector[idx1] = j;
 					var->value = j;
 
+					// solve the sweep points DC_BLOCK_SIZE at a time
+					if (dc_block_solver()) {
+						dc_block_push(j, probes, probes_num);
+						continue;
+					}
+
 					switch(solver_type) {
 						case LU_SOLVER:
 							solve_lu();
@@ -1018,41 +1829,49 @@ void execute_commands() {
 						case CHOL_SOLVER:
 							solve_cholesky();
 							break;
-						case CG_SOLVER:
-							solve_CG_iter_method();
-							break;
 						case BI_CG_SOLVER:
 							solve_BI_CG_iter_method();
 							break;
+						case BICGSTAB_SOLVER:
+							solve_BICGSTAB_iter_method();
+							break;
+						case GMRES_SOLVER:
+							solve_GMRES_iter_method();
+							break;
 						default:
 							break;
 					}
 
-					/*fprintf(node_fp, "%lf\t\t%lf\n", j, node->val);*/
-					fprintf(node_fp, "%lf\t\t%e\n", j, node->val);
+					for (k = 0; k < probes_num; k++) {
+						fprintf(probes[k].fp, "%lf\t\t%e\n", j, probes[k].node->val);
+					}
 				}
 
 			}
 
+			// solve the sweep points left in the last block
+			if (dc_block_solver())
+				dc_block_flush(probes, probes_num, 1);
+
 			// restore default b vector values
 			memcpy(mna_vector, default_mna_vector_copy, mna_dimension_size*sizeof(double));
 			var->value = var->op_point_val;
 
 
-			fprintf(fp_draw, "gnuplot -e \"set terminal png size 1024, 1024;");
-			fprintf(fp_draw, "set output \\\"%s_DC_%s.png\\\";",node_name,var_name);
-			fprintf(fp_draw, "plot \\\"%s\\\" using 1:2 with linespoints;\"\n", filename);
+			for (k = 0; k < probes_num; k++) {
+				fprintf(fp_draw, "gnuplot -e \"set terminal png size 1024, 1024;");
+				fprintf(fp_draw, "set output \\\"%s_DC_%s.png\\\";",probes[k].name,var_name);
+				fprintf(fp_draw, "plot \\\"%s\\\" using 1:2 with linespoints;\"\n", probes[k].filename);
 
-			// redirect sterr to stdout and redirect stdout to /dev/null to avoid viewing xdg-open warnings
-			fprintf(fp_draw, "xdg-open \"%s_DC_%s.png\" > /dev/null 2>&1\n",node_name,var_name);
+				// redirect sterr to stdout and redirect stdout to /dev/null to avoid viewing xdg-open warnings
+				fprintf(fp_draw, "xdg-open \"%s_DC_%s.png\" > /dev/null 2>&1\n",probes[k].name,var_name);
+			}
 
 
-			fclose(node_fp);
 			fclose(fp_draw);
-			free(node_name);
-			free(filename);
-			node_name = NULL;
-			filename = NULL;
+			free_probes(probes, probes_num);
+			probes = NULL;
+			probes_num = 0;
 
 			//memcpy(mna_vector, default_mna_vector_copy, mna_dimension_size*sizeof(double));
 			gsl_vector_memcpy(gsl_x_vector, default_X_vector_copy);
@@ -1101,80 +1920,27 @@ void execute_commands() {
 		if ((plot_type == TRAN_PLOT) &&
 			((strncmp(command_list[i], ".PRINT ", 7) == 0) || (strncmp(command_list[i], ".PLOT ", 6) == 0))) {
 
-
-			// bypass command name
-			token = strtok(command_list[i], delim);
-			if (token == NULL) {
-				printf(RED "Error" NRM ": Not enough arguments (%s)\n Bypassing..\n", command_list[i]);
-				continue;
-			}
-
-			// check if the node is written correctly in command (syntax check)
-			token = strtok(NULL, delim);
-			printf("token: %s\n", token);
-			if (token == NULL) {
-				printf(RED "Error" NRM ": Not enough arguments (%s)\n Bypassing..\n", command_list[i]);
-				continue;
-			}
-			if ((toupper(token[0]) != 'V') || (token[1] != '(') || (token[strlen(token)-1] != ')') ) {
-				printf(RED "Error" NRM ": Invalid argument value (%s)\n Bypassing..\n", token);
-				continue;
-			}
-
-			// checks were successsful. store node name into a variable
-			// +1 for '\0', -1 for 'v', -1 for '(' and -1 for ')'
-			node_name = malloc( (strlen(token) - 2)*sizeof(char));
-			if (node_name == NULL) {
-				printf("Error. Memory allocation problems. Exiting..\n");
-				exit(EXIT_FAILURE);
-			}
-			snprintf(node_name, strlen(token)-2, "%s", &token[2]);
-
-
-			// search for the node in the hashtable
-			node = ht_get(node_name);
-			if (node == NULL) {
-				printf(RED "Error" NRM ": Node not found (%s)\n Bypassing\n", token);
-				node_name = NULL;
+			// gather all the subsequent plot commands so that the time loop
+			// runs only once and writes every probed node at each time step
+			probes = parse_probes(&i, &probes_num);
+			if (probes_num == 0)
 				continue;
-			}
 
-			//*********
-			// now that we have successfully located the node in the hash table and aquired
-			// its pointer we are rereading the name including the parantheses. This is used only for
-			// file name generation
-			node_name = realloc(node_name,(strlen(token)+1)*sizeof(char));
-			if (node_name == NULL) {
-				printf("Error. Memory allocation problems. Exiting..\n");
-				exit(EXIT_FAILURE);
-			}
-			snprintf(node_name, strlen(token)+1, "%s", &token[0]);
-			//*********
-
-
-			// there should be no more arguments (syntax check)
-			token = strtok(NULL, delim);
-			if (token != NULL) {
-				printf(RED "Error" NRM ": Command contains extra false arguments (%s)\n Bypassing\n", command_list[i]);
-				free(node_name);
-				node_name = NULL;
-				continue;
-			}
-
-			// reminder: variable var_name is the I or V that changes value during the DC or TRAN analysis
-			// strlen(node_name) + 10 = strlen(node_name) + strlen("_TRAN") + strlen(".txt") + 1 for '\0'
-			filename = (char *) malloc((strlen(node_name) + 10)*sizeof(char));
-			if (filename == NULL) {
-				printf("Error. Memory allocation problems. Exiting..\n");
-				exit(EXIT_FAILURE);
-			}
+			for (k = 0; k < probes_num; k++) {
+				// strlen(name) + 10 = strlen(name) + strlen("_TRAN") + strlen(".txt") + 1 for '\0'
+				probes[k].filename = (char *) malloc((strlen(probes[k].name) + 10)*sizeof(char));
+				if (probes[k].filename == NULL) {
+					printf("Error. Memory allocation problems. Exiting..\n");
+					exit(EXIT_FAILURE);
+				}
 
-			sprintf(filename, "%s_TRAN.txt", node_name);
+				sprintf(probes[k].filename, "%s_TRAN.txt", probes[k].name);
 
-			node_fp = fopen(filename, "w");
-			if (node_fp == NULL) {
-				perror("fopen");
-				exit(EXIT_FAILURE);
+				probes[k].fp = fopen(probes[k].filename, "w");
+				if (probes[k].fp == NULL) {
+					perror("fopen");
+					exit(EXIT_FAILURE);
+				}
 			}
 
 			// GNUPLOT script
@@ -1194,13 +1960,6 @@ void execute_commands() {
 				// this function also handles sparse matrices
 				create_trans_MNA_array();
 
-				if ((is_sparse) && ((solver_type == LU_SOLVER) || (solver_type == CHOL_SOLVER))) {
-					if (css_S)
-						cs_sfree(css_S);
-					if (csn_N)
-						cs_nfree(csn_N);
-				}
-
 				if (is_sparse) {
 					printf("G Array (compressed column)\n\n");
 					print_sparse_matrix(compr_col_G);
@@ -1235,11 +1994,9 @@ void execute_commands() {
 					// iterative solving method. No need to decompose
 					case CG_SOLVER:
 					case BI_CG_SOLVER:
+					case BICGSTAB_SOLVER:
+					case GMRES_SOLVER:
 						free_gsl_vectors();
-						if (p_vector)
-							free(p_vector);
-						if (q_vector)
-							free(q_vector);
 						initialise_iter_methods();
 
 						break;
@@ -1339,71 +2096,26 @@ void execute_commands() {
 
 
 
-				memset(B_vector,0,mna_dimension_size*sizeof(double));
-
 				/*printf("j = %lf\n", j);*/
 				/*for (int p = 0; p < mna_dimension_size; p++)*/
 					/*printf("%d: %lf, \t%lf \t(old | new)\n", p, old_mna_vector[p], mna_vector[p]);*/
 				/*printf("\n");*/
 
-				if(tr_method == BACKWARD_EULER) {
-
-					if(is_sparse){
-						if (cs_gaxpy(compr_col_C, gsl_old_x_vector->data, B_vector) == 0) {
-							printf("Error in cs_gaxpy. Exiting..\n");
-							exit(EXIT_FAILURE);
-						}
-						for(k=0; k < mna_dimension_size; k++){
-							B_vector[k] = mna_vector[k] + (1/timestep)* B_vector[k];
-						}
-
-					}
-					else {
-						for(k=0; k < mna_dimension_size; k++){
-							// no need to iterate k when it is sparse (!?)
-							for(l=0; l < mna_dimension_size; l++){
-								B_vector[k] = B_vector[k] \
-											+ C_array[mna_dimension_size*k + l] \
-											* gsl_vector_get(gsl_old_x_vector,l);
-							}
-
-							B_vector[k] = mna_vector[k] + (1/timestep)* B_vector[k];
-						}
-					}
+				// the history matrix H is built once per timestep by create_trans_MNA_array()
+				// (in sparse form for dense matrices too, so that only its nonzeros are visited)
+				// BE: B = b(t) + H*x_old = b(t) + (1/h)*C*x_old
+				// TR: B = b(t) + b(t-h) + H*x_old = b(t) + b(t-h) - (G - (2/h)*C)*x_old
+				if (tr_method == BACKWARD_EULER) {
+					memcpy(B_vector, mna_vector, mna_dimension_size*sizeof(double));
 				}
 				else {
-
-
-					if(is_sparse){
-						compr_col_temp = cs_add(compr_col_G, compr_col_C,1,-1*(2/timestep));
-
-						// B = (G + (2/h)*C)*x_old
-						if (cs_gaxpy(compr_col_temp,gsl_old_x_vector->data,B_vector) == 0) {
-							printf("Error. in cs_gaxpy. Exiting..\n");
-							exit(EXIT_FAILURE);
-						}
-
-						cs_spfree(compr_col_temp);
-						for(k=0; k < mna_dimension_size; k++) {
-							B_vector[k] = mna_vector[k] + old_mna_vector[k] - B_vector[k];
-						}
-					}
-					else {
-
-						for(k=0; k < mna_dimension_size; k++) {
-
-							for(l=0; l < mna_dimension_size; l++) {
-								B_vector[k] = B_vector[k] \
-									+ (G_array[mna_dimension_size*k + l] \
-									- (2/timestep)*C_array[mna_dimension_size*k + l]) \
-									* gsl_vector_get(gsl_old_x_vector,l);
-							}
-
-							B_vector[k] = mna_vector[k] + old_mna_vector[k] - B_vector[k];
-						}
+					for(k=0; k < mna_dimension_size; k++) {
+						B_vector[k] = mna_vector[k] + old_mna_vector[k];
 					}
 				}
 
+				spmv_transpose(compr_row_H, 1.0, gsl_old_x_vector->data, 1.0, B_vector);
+
 
 				gsl_vector_memcpy(gsl_old_x_vector,gsl_x_vector);
 				memcpy(old_mna_vector,mna_vector,mna_dimension_size*sizeof(double));
@@ -1423,6 +2135,12 @@ void execute_commands() {
 					case BI_CG_SOLVER:
 						solve_BI_CG_iter_method();
 						break;
+					case BICGSTAB_SOLVER:
+						solve_BICGSTAB_iter_method();
+						break;
+					case GMRES_SOLVER:
+						solve_GMRES_iter_method();
+						break;
 					default:
 						break;
 				}
@@ -1431,7 +2149,9 @@ void execute_commands() {
 					memcpy(gsl_x_vector->data, mna_vector, mna_dimension_size*sizeof(double));
 				}
 
-				fprintf(node_fp, "%lf\t\t%e\n", j, node->val);
+				for (k = 0; k < probes_num; k++) {
+					fprintf(probes[k].fp, "%lf\t\t%e\n", j, probes[k].node->val);
+				}
 
 				/*
 				for(int p = 0 ; p< mna_dimension_size;p++){
@@ -1449,20 +2169,18 @@ void execute_commands() {
 			free(B_vector);
 
 			//Draw plot
+			for (k = 0; k < probes_num; k++) {
+				fprintf(fp_draw, "gnuplot -e \"set terminal png size 1024, 1024;");
+				fprintf(fp_draw, "set output \\\"%s_TRANS.png\\\";",probes[k].name);
+				fprintf(fp_draw, "plot \\\"%s\\\" using 1:2 with linespoints;\"\n", probes[k].filename);
+				// redirect sterr to stdout and redirect stdout to /dev/null to avoid viewing xdg-open warnings
+				fprintf(fp_draw, "xdg-open \"%s_TRANS.png\" > /dev/null 2>&1\n",probes[k].name);
+			}
 
-			fprintf(fp_draw, "gnuplot -e \"set terminal png size 1024, 1024;");
-			fprintf(fp_draw, "set output \\\"%s_TRANS.png\\\";",node_name);
-			fprintf(fp_draw, "plot \\\"%s\\\" using 1:2 with linespoints;\"\n", filename);
-			// redirect sterr to stdout and redirect stdout to /dev/null to avoid viewing xdg-open warnings
-			fprintf(fp_draw, "xdg-open \"%s_TRANS.png\" > /dev/null 2>&1\n",node_name);
-
-
-			fclose(node_fp);
 			fclose(fp_draw);
-			free(filename);
-			free(node_name);
-
-
+			free_probes(probes, probes_num);
+			probes = NULL;
+			probes_num = 0;
 		}
 	}
 
@@ -1481,9 +2199,12 @@ void execute_commands() {
 
 
 
-// calculate A = G + factor*C
+// calculate A = G + factor*C and the history matrix H
 void create_trans_MNA_array() {
 	unsigned long i, j;
+	double h_val;
+	int nz;
+	cs *compr_H = NULL;
 
 	if (tr_method == BACKWARD_EULER)
 		factor = 1/timestep;
@@ -1495,6 +2216,28 @@ void create_trans_MNA_array() {
 			cs_spfree(compr_col_A);
 		compr_col_A = NULL;
 		compr_col_A = cs_add(compr_col_G, compr_col_C, 1, factor);
+
+		// history matrix applied to the previous solution at each time step
+		// BE: (1/h)*C, TR: (2/h)*C - G
+		if (compr_row_H)
+			cs_spfree(compr_row_H);
+		if (tr_method == BACKWARD_EULER)
+			compr_H = cs_add(compr_col_C, compr_col_C, factor, 0);
+		else
+			compr_H = cs_add(compr_col_G, compr_col_C, -1, factor);
+
+		if ((compr_col_A == NULL) || (compr_H == NULL)) {
+			printf("Error in cs_add\n");
+			exit(EXIT_FAILURE);
+		}
+
+		// H is kept by rows, so that H*x_old is computed row by row
+		compr_row_H = cs_transpose(compr_H, 1);
+		cs_spfree(compr_H);
+		if (compr_row_H == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 	else {
 		for (i=0; i < mna_dimension_size; i++) {
@@ -1503,6 +2246,51 @@ void create_trans_MNA_array() {
 													+ factor * C_array[i*mna_dimension_size + j];
 			}
 		}
+
+		// the history matrix keeps only the nonzeros of the dense arrays (stored by rows)
+		// so that each time step costs O(nnz) instead of O(n^2)
+		if (compr_row_H)
+			cs_spfree(compr_row_H);
+		compr_row_H = NULL;
+
+		// first pass: count the nonzeros
+		nz = 0;
+		for (i=0; i < mna_dimension_size; i++) {
+			for (j=0; j < mna_dimension_size; j++) {
+				if ((C_array[i*mna_dimension_size + j] != 0) || \
+					((tr_method == TRAPEZOIDAL) && (G_array[i*mna_dimension_size + j] != 0)))
+					nz++;
+			}
+		}
+
+		compr_row_H = cs_spalloc(mna_dimension_size, mna_dimension_size, nz, 1, 0);
+		if (compr_row_H == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+
+		// second pass: fill the rows
+		nz = 0;
+		for (i=0; i < mna_dimension_size; i++) {
+			compr_row_H->p[i] = nz;
+			for (j=0; j < mna_dimension_size; j++) {
+				if (tr_method == BACKWARD_EULER) {
+					if (C_array[i*mna_dimension_size + j] == 0)
+						continue;
+					h_val = factor * C_array[i*mna_dimension_size + j];
+				}
+				else {
+					if ((C_array[i*mna_dimension_size + j] == 0) && (G_array[i*mna_dimension_size + j] == 0))
+						continue;
+					h_val = factor * C_array[i*mna_dimension_size + j] - G_array[i*mna_dimension_size + j];
+				}
+
+				compr_row_H->i[nz] = j;
+				compr_row_H->x[nz] = h_val;
+				nz++;
+			}
+		}
+		compr_row_H->p[mna_dimension_size] = nz;
 	}
 }
 
@@ -1513,7 +2301,13 @@ void reset_MNA_array() {
 		if (compr_col_A)
 			cs_spfree(compr_col_A);
 		compr_col_A = NULL;
-		compr_col_A = cs_add(compr_col_G, compr_col_G, 1, 0);
+		// G + 0*C keeps the pattern of G + factor*C so that the symbolic
+		// analysis of the transient array can be reused
+		compr_col_A = cs_add(compr_col_G, compr_col_C, 1, 0);
+		if (compr_col_A == NULL) {
+			printf("Error in cs_add\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 	else {
 		memcpy(mna_array, G_array, (mna_dimension_size * mna_dimension_size * sizeof(double)));
@@ -2134,7 +2928,10 @@ void free_gsl_vectors(){
 	gsl_vector_free(gsl_q_vector);
 	gsl_q_vector = NULL;
 
-	if(solver_type == BI_CG_SOLVER){
+	gmres_free();
+	dc_block_free();
+
+	if((solver_type == BI_CG_SOLVER) || (solver_type == BICGSTAB_SOLVER)){
 		gsl_vector_free(gsl_zT_vector);
 		gsl_zT_vector = NULL;
 		gsl_vector_free(gsl_rT_vector);
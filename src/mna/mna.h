@@ -5,6 +5,8 @@
 #include <gsl/gsl_errno.h>
 #include "../csparse/csparse.h"
 #include "../lists/lists.h"
+#include "../trisolve/trisolve.h"
+#include "../supernodal/supernodal.h"
 
 extern double *mna_array;
 extern double *mna_vector;
@@ -26,10 +28,23 @@ extern double *C_array;
 #define MAX_ITER		100
 #define ITOL_DEFAULT	10e-6
 #define EPS_DEFAULT		10e-16
+#define LU_REFACTOR_TOL	1e-3	// smallest accepted |pivot| / max|column| when reusing pivots
 #define LU_SOLVER		0
 #define CHOL_SOLVER		1
 #define CG_SOLVER		2
 #define BI_CG_SOLVER	3
+#define BICGSTAB_SOLVER	4
+#define GMRES_SOLVER	5
+#define GMRES_RESTART_DEFAULT	30	// Krylov basis size of GMRES(m)
+#define BICGSTAB_MAX_RESTARTS	5	// breakdowns of BiCGSTAB before switching to GMRES
+#define DC_BLOCK_SIZE	CS_BLOCK_WIDTH	// DC sweep points solved together (CG and sparse LU/Cholesky)
+// iterative methods for nonsymmetric arrays (they need A stored by rows)
+#define IS_NONSYM_ITER(s)	(((s) == BI_CG_SOLVER) || ((s) == BICGSTAB_SOLVER) || ((s) == GMRES_SOLVER))
+#define JACOBI_PRECOND	0
+#define ILU0_PRECOND	1
+#define AMG_PRECOND		2
+#define ORDER_AMD		0	// fill-reducing orderings of the sparse factorizations
+#define ORDER_ND		1
 #define TRAPEZOIDAL		0
 #define BACKWARD_EULER	1
 #define DC_PLOT			0
@@ -38,7 +53,20 @@ extern double *C_array;
 
 extern double itol;
 
+// a node probed by a .PLOT/.PRINT command and the file its values are written to
+typedef struct plot_probe {
+	element_h *node;
+	char *name;		// V(<node name>), used for file name generation
+	char *filename;
+	FILE *fp;
+} plot_probe;
+
 extern byte solver_type;
+extern byte nonsym_solver_type;
+extern unsigned int gmres_restart;
+extern byte precond_type;
+extern byte active_precond;
+extern byte order_type;
 extern byte tr_method;
 extern byte is_sparse;
 extern byte is_trans;
@@ -53,9 +81,15 @@ extern cs *compr_col_A;
 extern cs *triplet_C;
 extern cs *compr_col_C;
 extern cs *compr_col_G;
+extern cs *compr_row_H;
+extern cs *compr_col_AT;
 
 extern css *css_S;
+extern tri_sched *tri_L;
+extern tri_sched *tri_U;
 extern csn *csn_N;
+extern cs *css_S_pattern;
+extern super_sym *super_Y;
 
 extern gsl_matrix_view gsl_mna_array;
 extern gsl_vector_view gsl_mna_vector;
@@ -70,8 +104,6 @@ extern gsl_vector *gsl_rT_vector;
 extern gsl_vector *gsl_pT_vector;
 extern gsl_vector *gsl_qT_vector;
 extern gsl_permutation *gsl_p;
-extern double *p_vector;
-extern double *q_vector;
 
 // functions for sparse matrixes
 extern void init_triplet();
@@ -87,22 +119,44 @@ extern void free_MNA_system();
 extern void print_MNA_array();
 extern void print_MNA_vector();
 extern void execute_commands();
+extern plot_probe *parse_probes(unsigned long *cmd_idx, unsigned long *probes_num);
+extern void free_probes(plot_probe *probes, unsigned long probes_num);
 
 
 extern void dump_MNA_nodes();
 
+extern byte same_sparsity_pattern(cs *A, cs *B);
+extern byte symbolic_needs_update();
+extern css *symbolic_analysis(byte chol);
+extern void print_fill_stats(cs *L, cs *U);
 extern void decomp_lu();
 extern void decomp_cholesky();
 extern void initialise_iter_methods();
 extern void solve_lu();
 extern void solve_cholesky();
 extern void solve_CG_iter_method();
+extern void init_iter_residual();
+extern void apply_precond(const double *r, double *z);
+extern void mna_spmv(const double *x, double *y);
 extern void solve_precond();
 extern void solve_q();
 extern void free_gsl_vectors();
 extern void solve_BI_CG_iter_method();
 extern void Transpose_solve_precond();
 extern void Transpose_solve_q();
+extern void solve_BICGSTAB_iter_method();
+extern void solve_GMRES_iter_method();
+extern void gmres_alloc();
+extern void gmres_free();
+extern void mna_spmm(int k, const double *X, double *Y);
+extern void solve_block_CG_iter_method(int k);
+extern void solve_lu_block(int k);
+extern void solve_cholesky_block(int k);
+extern byte dc_block_solver();
+extern void dc_block_alloc();
+extern void dc_block_free();
+extern void dc_block_push(double val, plot_probe *probes, unsigned long probes_num);
+extern void dc_block_flush(plot_probe *probes, unsigned long probes_num, byte sweep_end);
 
 extern double get_exp_val(ExpInfoT *data, double t);
 extern double get_sin_val(SinInfoT *data, double t);
@@ -0,0 +1,610 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "netcache.h"
+#include "../spicy.h"
+#include "../hashtable/hashtable.h"
+#include "../lists/lists.h"
+#include "../cir_parser/cir_parser.h"
+
+
+// the image of a compiled netlist is
+//   nc_header
+//   offsets of the node names, in id order	(uint64_t[nodes_num])
+//   team1_list and team2_list elements		(nc_element[team1_num + team2_num])
+//   sec_list elements						(nc_sec_element[sec_num])
+//   offsets of the commands, in file order	(uint64_t[commands_num])
+//   PWL times and values					(double[doubles_num])
+//   strings								(char[strings_size])
+// Every section is a multiple of 8 bytes, so the mapped image is used in place.
+// The image is only meant for the machine that wrote it (native byte order)
+
+// identifies the version of the netlist that was compiled
+typedef struct nc_key {
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t sample_hash;
+} nc_key;
+
+typedef struct nc_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t elem_size;		// sizeof(list_element), changes with the lists
+	nc_key key;
+	uint64_t components_num;
+	uint64_t nodes_num;
+	uint64_t team1_num;
+	uint64_t team2_num;
+	uint64_t sec_num;
+	uint64_t commands_num;
+	uint64_t doubles_num;
+	uint64_t strings_size;
+} nc_header;
+
+typedef struct nc_element {
+	int32_t type;
+	int32_t tr_type;
+	uint64_t name;
+	uint64_t node_plus;
+	uint64_t node_minus;
+	double value;
+	double spec[7];			// arguments of EXP, SIN and PULSE
+	uint64_t pwl_pos;		// times at pwl_pos, values right after them
+	uint64_t pwl_num;
+} nc_element;
+
+typedef struct nc_sec_element {
+	int32_t type;
+	int32_t pad;
+	uint64_t name;
+	uint64_t model_name;
+	uint64_t nodes[4];
+	int64_t l;
+	int64_t w;
+} nc_sec_element;
+
+// growable section of the image
+typedef struct nc_buf {
+	char *data;
+	size_t size;
+	size_t cap;
+} nc_buf;
+
+
+byte nc_recording = 0;
+
+// the commands of the netlist, recorded while it is parsed
+char **nc_commands = NULL;
+unsigned long nc_commands_num = 0;
+
+
+// keeps a copy of a command before parse_command() modifies it
+void nc_record_command(const char *command) {
+
+	nc_commands = (char **) realloc(nc_commands, (nc_commands_num + 1)*sizeof(char *));
+	if (nc_commands == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	nc_commands[nc_commands_num] = strdup(command);
+	if (nc_commands[nc_commands_num] == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	nc_commands_num++;
+}
+
+
+static void nc_free_commands() {
+	unsigned long i;
+
+	for (i = 0; i < nc_commands_num; i++)
+		free(nc_commands[i]);
+	free(nc_commands);
+	nc_commands = NULL;
+	nc_commands_num = 0;
+}
+
+
+// appends len bytes (padded to a multiple of 8) to B. Returns their offset
+static uint64_t nc_buf_add(nc_buf *B, const void *data, size_t len) {
+	size_t pos = B->size;
+	size_t padded = (len + 7) & ~((size_t) 7);
+
+	if (B->size + padded > B->cap) {
+		B->cap = (B->cap == 0) ? 65536 : 2*B->cap;
+		if (B->cap < B->size + padded)
+			B->cap = B->size + padded;
+		B->data = (char *) realloc(B->data, B->cap);
+		if (B->data == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memcpy(&B->data[pos], data, len);
+	memset(&B->data[pos + len], 0, padded - len);
+	B->size += padded;
+
+	return pos;
+}
+
+
+static uint64_t nc_string(nc_buf *B, const char *str) {
+	return nc_buf_add(B, str, strlen(str) + 1);
+}
+
+
+// 64 bit FNV-1a
+static uint64_t nc_hash(uint64_t h, const unsigned char *data, size_t len) {
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h ^= data[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+
+// key of the netlist: its size, its modification time and a hash of its
+// first and last NC_SAMPLE_SIZE bytes (reading all of a multi GB netlist
+// would cost about as much as parsing it). Returns 0 on error
+static int nc_source_key(const char *filename, nc_key *K) {
+	unsigned char *sample;
+	struct stat st;
+	ssize_t len;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1)
+		return 0;
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		return 0;
+	}
+
+	memset(K, 0, sizeof(nc_key));
+	K->size = st.st_size;
+	K->mtime_sec = st.st_mtim.tv_sec;
+	K->mtime_nsec = st.st_mtim.tv_nsec;
+	K->sample_hash = 14695981039346656037ULL;
+
+	sample = (unsigned char *) malloc(NC_SAMPLE_SIZE);
+	if (sample == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	len = pread(fd, sample, NC_SAMPLE_SIZE, 0);
+	if (len > 0)
+		K->sample_hash = nc_hash(K->sample_hash, sample, len);
+	if (K->size > NC_SAMPLE_SIZE) {
+		len = pread(fd, sample, NC_SAMPLE_SIZE, K->size - NC_SAMPLE_SIZE);
+		if (len > 0)
+			K->sample_hash = nc_hash(K->sample_hash, sample, len);
+	}
+	free(sample);
+	close(fd);
+
+	return 1;
+}
+
+
+static void nc_path(char *path, const char *filename) {
+	strcpy(path, filename);
+	strcat(path, NC_SUFFIX);
+}
+
+
+static void nc_put_list(nc_buf *E, nc_buf *D, nc_buf *S, list_head *list) {
+	list_element *el;
+	nc_element e;
+	PwlInfoT *pwl;
+	unsigned long i;
+
+	for (i = 0; i < list->size; i++) {
+		el = &list->list[i];
+
+		memset(&e, 0, sizeof(nc_element));
+		e.type = el->type;
+		e.tr_type = el->tr_type;
+		e.name = nc_string(S, el->name);
+		e.node_plus = el->node_plus->id;
+		e.node_minus = el->node_minus->id;
+		e.value = el->value;
+
+		switch (el->tr_type) {
+			case TR_TYPE_EXP:
+				memcpy(e.spec, el->tran_spec.exp_data, sizeof(ExpInfoT));
+				break;
+			case TR_TYPE_SIN:
+				memcpy(e.spec, el->tran_spec.sin_data, sizeof(SinInfoT));
+				break;
+			case TR_TYPE_PULSE:
+				memcpy(e.spec, el->tran_spec.pulse_data, sizeof(PulseInfoT));
+				break;
+			case TR_TYPE_PWL:
+				pwl = el->tran_spec.pwl_data;
+				e.pwl_num = pwl->total_tuples;
+				e.pwl_pos = nc_buf_add(D, pwl->times, pwl->total_tuples*sizeof(double)) / sizeof(double);
+				nc_buf_add(D, pwl->values, pwl->total_tuples*sizeof(double));
+				break;
+		}
+
+		nc_buf_add(E, &e, sizeof(nc_element));
+	}
+}
+
+
+// writes the compiled image of the netlist that was just parsed
+void nc_save(const char *filename, unsigned long components_num) {
+	char path[BUF_MAX + sizeof(NC_SUFFIX)];
+	char tmp_path[BUF_MAX + sizeof(NC_SUFFIX) + 4];
+	nc_buf nodes = {NULL, 0, 0};
+	nc_buf elems = {NULL, 0, 0};
+	nc_buf secs = {NULL, 0, 0};
+	nc_buf cmds = {NULL, 0, 0};
+	nc_buf doubles = {NULL, 0, 0};
+	nc_buf strings = {NULL, 0, 0};
+	nc_buf *sections[6] = {&nodes, &elems, &secs, &cmds, &doubles, &strings};
+	sec_list_element *sl;
+	nc_sec_element s;
+	nc_header H;
+	uint64_t off;
+	unsigned long i;
+	FILE *fp;
+	int ok = 1;
+
+	nc_recording = 0;
+
+	memset(&H, 0, sizeof(nc_header));
+	if (nc_source_key(filename, &H.key) == 0) {
+		nc_free_commands();
+		return;
+	}
+	memcpy(H.magic, NC_MAGIC, sizeof(NC_MAGIC));
+	H.version = NC_VERSION;
+	H.elem_size = sizeof(list_element);
+	H.components_num = components_num;
+
+	for (i = 0; i < total_ids; i++) {
+		off = nc_string(&strings, id_to_node[i]->name);
+		nc_buf_add(&nodes, &off, sizeof(uint64_t));
+	}
+
+	nc_put_list(&elems, &doubles, &strings, &team1_list);
+	nc_put_list(&elems, &doubles, &strings, &team2_list);
+
+	for (i = 0; i < sec_list.size; i++) {
+		sl = &sec_list.list[i];
+
+		memset(&s, 0, sizeof(nc_sec_element));
+		s.type = sl->type;
+		s.name = nc_string(&strings, sl->name);
+		s.model_name = nc_string(&strings, sl->model_name);
+		switch (sl->type) {
+			case D:
+				s.nodes[0] = sl->character.diode.node_plus->id;
+				s.nodes[1] = sl->character.diode.node_minus->id;
+				break;
+			case M:
+				s.nodes[0] = sl->character.mos.node_d->id;
+				s.nodes[1] = sl->character.mos.node_g->id;
+				s.nodes[2] = sl->character.mos.node_s->id;
+				s.nodes[3] = sl->character.mos.node_b->id;
+				s.l = sl->character.mos.l;
+				s.w = sl->character.mos.w;
+				break;
+			default:	// Q
+				s.nodes[0] = sl->character.bjt.node_c->id;
+				s.nodes[1] = sl->character.bjt.node_b->id;
+				s.nodes[2] = sl->character.bjt.node_e->id;
+				break;
+		}
+		nc_buf_add(&secs, &s, sizeof(nc_sec_element));
+	}
+
+	for (i = 0; i < nc_commands_num; i++) {
+		off = nc_string(&strings, nc_commands[i]);
+		nc_buf_add(&cmds, &off, sizeof(uint64_t));
+	}
+	nc_free_commands();
+
+	H.nodes_num = total_ids;
+	H.team1_num = team1_list.size;
+	H.team2_num = team2_list.size;
+	H.sec_num = sec_list.size;
+	H.commands_num = cmds.size / sizeof(uint64_t);
+	H.doubles_num = doubles.size / sizeof(double);
+	H.strings_size = strings.size;
+
+	// written under a temporary name, so that an interrupted run
+	// never leaves a truncated image behind
+	nc_path(path, filename);
+	sprintf(tmp_path, "%s.tmp", path);
+	fp = fopen(tmp_path, "wb");
+	if (fp == NULL) {
+		printf(YEL "Warning:" NRM " Cannot write compiled netlist %s\n", path);
+	}
+	else {
+		ok = (fwrite(&H, sizeof(nc_header), 1, fp) == 1);
+		for (i = 0; ok && (i < 6); i++) {
+			if (sections[i]->size > 0)
+				ok = (fwrite(sections[i]->data, sections[i]->size, 1, fp) == 1);
+		}
+		if ((fclose(fp) != 0) || !ok || (rename(tmp_path, path) != 0)) {
+			printf(YEL "Warning:" NRM " Cannot write compiled netlist %s\n", path);
+			unlink(tmp_path);
+		}
+		else {
+			printf("Compiled netlist written to %s\n", path);
+		}
+	}
+
+	for (i = 0; i < 6; i++)
+		free(sections[i]->data);
+}
+
+
+static void nc_get_list(list_head *list, nc_element *E, unsigned long num, \
+						double *doubles, char *strings) {
+	list_element *el;
+	PwlInfoT *pwl;
+	unsigned long i;
+	size_t spec_size = 0;
+
+	list->size = num;
+	list->list = NULL;
+	if (num == 0)
+		return;
+
+	list->list = (list_element *) malloc(num*sizeof(list_element));
+	if (list->list == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0; i < num; i++) {
+		el = &list->list[i];
+
+		el->type = (c_type) E[i].type;
+		el->name = strdup(&strings[E[i].name]);
+		el->node_plus = id_to_node[E[i].node_plus];
+		el->node_minus = id_to_node[E[i].node_minus];
+		el->op_point_val = E[i].value;
+		el->value = E[i].value;
+		el->tr_type = E[i].tr_type;
+		el->tran_spec.data = NULL;
+
+		switch (E[i].tr_type) {
+			case TR_TYPE_EXP:
+				spec_size = sizeof(ExpInfoT);
+				break;
+			case TR_TYPE_SIN:
+				spec_size = sizeof(SinInfoT);
+				break;
+			case TR_TYPE_PULSE:
+				spec_size = sizeof(PulseInfoT);
+				break;
+			case TR_TYPE_PWL:
+				spec_size = sizeof(PwlInfoT);
+				break;
+			default:
+				spec_size = 0;
+				break;
+		}
+		if (spec_size > 0) {
+			el->tran_spec.data = malloc(spec_size);
+			if (el->tran_spec.data == NULL) {
+				printf("Error. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		if (E[i].tr_type == TR_TYPE_PWL) {
+			pwl = el->tran_spec.pwl_data;
+			pwl->total_tuples = E[i].pwl_num;
+			pwl->times = (double *) malloc(E[i].pwl_num*sizeof(double));
+			pwl->values = (double *) malloc(E[i].pwl_num*sizeof(double));
+			if ((pwl->times == NULL) || (pwl->values == NULL)) {
+				printf("Error. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
+			memcpy(pwl->times, &doubles[E[i].pwl_pos], E[i].pwl_num*sizeof(double));
+			memcpy(pwl->values, &doubles[E[i].pwl_pos + E[i].pwl_num], E[i].pwl_num*sizeof(double));
+		}
+		else if (spec_size > 0) {
+			memcpy(el->tran_spec.data, E[i].spec, spec_size);
+		}
+
+		if (el->name == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+
+// checks that every offset of the image points inside its section, so that
+// a damaged image is never read outside the mapping. Returns 1 if it is valid
+static int nc_check(const nc_header *H, const uint64_t *node_offs, const nc_element *elems, \
+					const nc_sec_element *secs, const uint64_t *cmd_offs, const char *strings) {
+	unsigned long i;
+	int k;
+
+	if ((H->nodes_num == 0) || (H->strings_size == 0) || (strings[H->strings_size - 1] != '\0'))
+		return 0;
+
+	for (i = 0; i < H->nodes_num; i++) {
+		if (node_offs[i] >= H->strings_size)
+			return 0;
+	}
+
+	for (i = 0; i < H->team1_num + H->team2_num; i++) {
+		if ((elems[i].name >= H->strings_size) || (elems[i].node_plus >= H->nodes_num) || \
+			(elems[i].node_minus >= H->nodes_num))
+			return 0;
+		// times and values of a PWL, 2*pwl_num doubles from pwl_pos
+		if ((elems[i].tr_type == TR_TYPE_PWL) && ((elems[i].pwl_num > H->doubles_num / 2) || \
+			(elems[i].pwl_pos > H->doubles_num - 2*elems[i].pwl_num)))
+			return 0;
+	}
+
+	for (i = 0; i < H->sec_num; i++) {
+		if ((secs[i].name >= H->strings_size) || (secs[i].model_name >= H->strings_size))
+			return 0;
+		for (k = 0; k < 4; k++) {
+			if (secs[i].nodes[k] >= H->nodes_num)
+				return 0;
+		}
+	}
+
+	for (i = 0; i < H->commands_num; i++) {
+		if (cmd_offs[i] >= H->strings_size)
+			return 0;
+	}
+
+	return 1;
+}
+
+
+// loads the compiled image of filename, when one exists for its current
+// version. The node table, the lists and the commands end up as if the
+// netlist was parsed. Returns 1 if the image was loaded, otherwise 0
+int nc_load(const char *filename, unsigned long *components_num) {
+	char path[BUF_MAX + sizeof(NC_SUFFIX)];
+	char *data = NULL;
+	nc_header *H;
+	nc_key key;
+	uint64_t *node_offs, *cmd_offs;
+	nc_element *elems;
+	nc_sec_element *secs;
+	sec_list_element *sl;
+	double *doubles;
+	char *strings;
+	struct stat st;
+	unsigned long i, id;
+	size_t expected;
+	int fd;
+
+	if (nc_source_key(filename, &key) == 0)
+		return 0;
+
+	nc_path(path, filename);
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return 0;
+	if ((fstat(fd, &st) == -1) || (st.st_size < (off_t) sizeof(nc_header))) {
+		close(fd);
+		return 0;
+	}
+
+	// one mapping for the whole image. It is private and writable,
+	// since the names and commands are upper-cased in place
+	data = (char *) mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return 0;
+	H = (nc_header *) data;
+
+	// no count can exceed the size of the file, so the sum below cannot overflow
+	expected = 0;
+	if ((H->nodes_num <= (uint64_t) st.st_size) && (H->team1_num <= (uint64_t) st.st_size) && \
+		(H->team2_num <= (uint64_t) st.st_size) && (H->sec_num <= (uint64_t) st.st_size) && \
+		(H->commands_num <= (uint64_t) st.st_size) && (H->doubles_num <= (uint64_t) st.st_size) && \
+		(H->strings_size <= (uint64_t) st.st_size)) {
+		expected = sizeof(nc_header) + H->nodes_num*sizeof(uint64_t) \
+				 + (H->team1_num + H->team2_num)*sizeof(nc_element) \
+				 + H->sec_num*sizeof(nc_sec_element) + H->commands_num*sizeof(uint64_t) \
+				 + H->doubles_num*sizeof(double) + H->strings_size;
+	}
+	if ((memcmp(H->magic, NC_MAGIC, sizeof(NC_MAGIC)) != 0) || (H->version != NC_VERSION) || \
+		(H->elem_size != sizeof(list_element)) || (expected != (size_t) st.st_size) || \
+		(memcmp(&H->key, &key, sizeof(nc_key)) != 0)) {
+		printf(YEL "Warning:" NRM " Compiled netlist %s is out of date. Parsing %s\n", path, filename);
+		munmap(data, st.st_size);
+		return 0;
+	}
+
+	node_offs = (uint64_t *) (data + sizeof(nc_header));
+	elems = (nc_element *) (node_offs + H->nodes_num);
+	secs = (nc_sec_element *) (elems + H->team1_num + H->team2_num);
+	cmd_offs = (uint64_t *) (secs + H->sec_num);
+	doubles = (double *) (cmd_offs + H->commands_num);
+	strings = (char *) (doubles + H->doubles_num);
+
+	// a damaged image is treated as an out of date one
+	if (nc_check(H, node_offs, elems, secs, cmd_offs, strings) == 0) {
+		printf(YEL "Warning:" NRM " Compiled netlist %s is out of date. Parsing %s\n", path, filename);
+		munmap(data, st.st_size);
+		return 0;
+	}
+
+	// the nodes are added in id order, so they get the same ids and
+	// the same places in the table as when they were parsed.
+	// The ground (id 0) is already in the table
+	id = 0;
+	for (i = 1; i < H->nodes_num; i++)
+		ht_get_or_put(&strings[node_offs[i]], &id);
+
+	nc_get_list(&team1_list, elems, H->team1_num, doubles, strings);
+	nc_get_list(&team2_list, elems + H->team1_num, H->team2_num, doubles, strings);
+
+	sec_list.size = H->sec_num;
+	sec_list.list = NULL;
+	if (H->sec_num > 0) {
+		sec_list.list = (sec_list_element *) malloc(H->sec_num*sizeof(sec_list_element));
+		if (sec_list.list == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0; i < H->sec_num; i++) {
+		sl = &sec_list.list[i];
+
+		sl->type = (c_type) secs[i].type;
+		sl->name = strdup(&strings[secs[i].name]);
+		sl->model_name = strdup(&strings[secs[i].model_name]);
+		if ((sl->name == NULL) || (sl->model_name == NULL)) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+		switch (sl->type) {
+			case D:
+				sl->character.diode.node_plus = id_to_node[secs[i].nodes[0]];
+				sl->character.diode.node_minus = id_to_node[secs[i].nodes[1]];
+				break;
+			case M:
+				sl->character.mos.node_d = id_to_node[secs[i].nodes[0]];
+				sl->character.mos.node_g = id_to_node[secs[i].nodes[1]];
+				sl->character.mos.node_s = id_to_node[secs[i].nodes[2]];
+				sl->character.mos.node_b = id_to_node[secs[i].nodes[3]];
+				sl->character.mos.l = secs[i].l;
+				sl->character.mos.w = secs[i].w;
+				break;
+			default:	// Q
+				sl->character.bjt.node_c = id_to_node[secs[i].nodes[0]];
+				sl->character.bjt.node_b = id_to_node[secs[i].nodes[1]];
+				sl->character.bjt.node_e = id_to_node[secs[i].nodes[2]];
+				break;
+		}
+	}
+
+	// the commands are executed again, in the order they were read,
+	// as they set the options and fill the command list
+	for (i = 0; i < H->commands_num; i++)
+		parse_command(&strings[cmd_offs[i]]);
+
+	*components_num = H->components_num;
+	printf("Compiled netlist loaded from %s (%lu nodes, %lu components)\n\n", \
+			path, (unsigned long) H->nodes_num, *components_num);
+
+	munmap(data, st.st_size);
+	return 1;
+}
@@ -0,0 +1,19 @@
+#ifndef _NETCACHE_H_
+#define _NETCACHE_H_
+
+// the compiled netlist of file.cir is stored next to it, as file.cir.spc
+#define NC_SUFFIX			".spc"
+#define NC_MAGIC			"SPICYNL"
+#define NC_VERSION			1
+// bytes hashed at the start and at the end of the netlist to tell
+// apart files that were changed without changing their size and mtime
+#define NC_SAMPLE_SIZE		65536
+
+// set while parsing a netlist whose compiled image will be written
+extern unsigned char nc_recording;
+
+extern void nc_record_command(const char *command);
+extern int nc_load(const char *filename, unsigned long *components_num);
+extern void nc_save(const char *filename, unsigned long components_num);
+
+#endif
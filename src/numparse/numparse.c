@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "numparse.h"
+
+
+static const double pow10_exact[NUM_EXACT_POW10 + 1] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+// reads a SPICE scale factor (case insensitive) at str. Returns its length
+// (0 if there is none), *pow10 holds its power of ten and *mil is set for MIL
+static int num_suffix(const char *str, int *pow10, int *mil) {
+	char c0 = toupper((unsigned char) str[0]);
+	char c1 = (c0 != '\0') ? toupper((unsigned char) str[1]) : '\0';
+	char c2 = (c1 != '\0') ? toupper((unsigned char) str[2]) : '\0';
+
+	*mil = 0;
+	switch (c0) {
+		case 'T': *pow10 = 12;  return 1;
+		case 'G': *pow10 = 9;   return 1;
+		case 'K': *pow10 = 3;   return 1;
+		case 'U': *pow10 = -6;  return 1;
+		case 'N': *pow10 = -9;  return 1;
+		case 'P': *pow10 = -12; return 1;
+		case 'F': *pow10 = -15; return 1;
+		case 'M':
+			if ((c1 == 'E') && (c2 == 'G')) {
+				*pow10 = 6;
+				return 3;
+			}
+			if ((c1 == 'I') && (c2 == 'L')) {	// 1 mil = 25.4e-6
+				*pow10 = 0;
+				*mil = 1;
+				return 3;
+			}
+			*pow10 = -3;
+			return 1;
+	}
+
+	*pow10 = 0;
+	return 0;
+}
+
+
+// converts the decimal number at str, optionally followed by a SPICE scale
+// factor (T, G, MEG, K, M, MIL, U, N, P, F), into *d. The number ends at the
+// end of the string or at the first stop character, anything after it is
+// ignored. Does not depend on the locale. Returns 1 on success, 0 if str is
+// not a number or the value overflows/underflows
+int num_parse(double *d, const char *str, char stop) {
+	const char *s = str;
+	const char *digits;			// first significant digit
+	uint64_t m = 0;
+	int neg = 0, any = 0;
+	int sig = 0;				// significant digits
+	int dropped = 0;			// significant digits beyond NUM_MAX_DIGITS
+	int frac = 0;				// significant digits after the point
+	long exp10 = 0, e = 0;
+	int e_neg, pow10, mil, len;
+	char buf[64];
+	char *big = NULL, *p, *end;
+	double v;
+
+	if ((*s == '+') || (*s == '-')) {
+		neg = (*s == '-');
+		s++;
+	}
+
+	// leading zeros are not significant
+	while (*s == '0') {
+		s++;
+		any = 1;
+	}
+	digits = s;
+	for (; isdigit((unsigned char) *s); s++, sig++) {
+		if (sig < NUM_MAX_DIGITS)
+			m = 10*m + (*s - '0');
+		else
+			dropped++;
+	}
+	if (*s == '.') {
+		s++;
+		if (sig == 0) {
+			while (*s == '0') {
+				s++;
+				frac++;
+				any = 1;
+			}
+			digits = s;
+		}
+		for (; isdigit((unsigned char) *s); s++, sig++, frac++) {
+			if (sig < NUM_MAX_DIGITS)
+				m = 10*m + (*s - '0');
+			else
+				dropped++;
+		}
+	}
+	any |= (sig > 0);
+	if (!any)
+		return 0;
+
+	// exponent (not to be confused with a scale factor starting with E)
+	if (((*s == 'e') || (*s == 'E')) &&
+		(isdigit((unsigned char) s[1]) ||
+		 (((s[1] == '+') || (s[1] == '-')) && isdigit((unsigned char) s[2])))) {
+		s++;
+		e_neg = (*s == '-');
+		if ((*s == '+') || (*s == '-'))
+			s++;
+		for (; isdigit((unsigned char) *s); s++) {
+			if (e < 100000)
+				e = 10*e + (*s - '0');
+		}
+		exp10 = e_neg ? -e : e;
+	}
+
+	len = num_suffix(s, &pow10, &mil);
+	s += len;
+	if ((*s != '\0') && (*s != stop))
+		return 0;
+	exp10 += pow10;
+
+	if (m == 0) {
+		*d = neg ? -0.0 : 0.0;
+		return 1;
+	}
+
+	// m * 10^(exp10 - frac + dropped) is exact when m and the power of ten are
+	if ((dropped == 0) && (m <= ((uint64_t)1 << 53)) &&
+		(exp10 - frac >= -NUM_EXACT_POW10) && (exp10 - frac <= NUM_EXACT_POW10)) {
+		if (exp10 - frac < 0)
+			v = (double) m / pow10_exact[frac - exp10];
+		else
+			v = (double) m * pow10_exact[exp10 - frac];
+	}
+	else {
+		// hand the digits to strtod as an integer mantissa and an exponent,
+		// without a decimal point that could depend on the locale
+		if (sig + 16 > (int) sizeof(buf)) {
+			big = (char *) malloc(sig + 16);
+			if (big == NULL) {
+				printf("Error. Memory allocation problems. Exiting..\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		p = (big != NULL) ? big : buf;
+		for (len = 0; len < sig; digits++) {
+			if (*digits != '.')
+				p[len++] = *digits;
+		}
+		sprintf(&p[len], "e%ld", exp10 - frac);
+
+		errno = 0;
+		v = strtod(p, &end);
+		free(big);
+		if (errno != 0)
+			return 0;
+	}
+
+	if (mil)
+		v *= 25.4e-6;
+	*d = neg ? -v : v;
+	return 1;
+}
@@ -0,0 +1,13 @@
+#ifndef _NUMPARSE_H_
+#define _NUMPARSE_H_
+
+// numbers with at most this many significant digits are accumulated
+// exactly into a 64 bit integer
+#define NUM_MAX_DIGITS		19
+// 10^k is exact in a double up to this k, so m * 10^k and m / 10^k are
+// correctly rounded for any mantissa m below 2^53
+#define NUM_EXACT_POW10		22
+
+extern int num_parse(double *d, const char *str, char stop);
+
+#endif
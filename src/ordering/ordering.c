@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ordering.h"
+
+
+// work arrays of the dissection. The vertices of every subgraph are kept
+// contiguous in verts, which ends up holding the ordering
+typedef struct nd_work {
+	const cs *G;		// adjacency of A+A' without the diagonal
+	int *verts;
+	int *pos;			// position of every vertex in verts
+	int *level;			// breadth first search level (-1: not reached)
+	int *queue;			// vertices in the order they were reached
+	int *level_ptr;		// vertices of level l: queue[level_ptr[l] .. level_ptr[l+1]-1]
+	int *tmp;
+} nd_work;
+
+
+// breadth first search of the subgraph verts[lo..hi-1] from root.
+// Returns the number of levels, *reached holds the number of vertices reached
+static int nd_bfs(nd_work *W, int lo, int hi, int root, int *reached) {
+	int *Gp = W->G->p;
+	int *Gi = W->G->i;
+	int head, tail, levels, v, u, p;
+
+	for (p = lo; p < hi; p++)
+		W->level[W->verts[p]] = -1;
+
+	W->queue[0] = root;
+	W->level[root] = 0;
+	head = 0;
+	tail = 1;
+	while (head < tail) {
+		v = W->queue[head++];
+		for (p = Gp[v]; p < Gp[v+1]; p++) {
+			u = Gi[p];
+			if ((W->pos[u] < lo) || (W->pos[u] >= hi) || (W->level[u] != -1))
+				continue;
+			W->level[u] = W->level[v] + 1;
+			W->queue[tail++] = u;
+		}
+	}
+
+	// the queue holds the levels one after the other
+	levels = 0;
+	W->level_ptr[0] = 0;
+	for (p = 0; p < tail; p++) {
+		if (W->level[W->queue[p]] == levels + 1)
+			W->level_ptr[++levels] = p;
+	}
+	W->level_ptr[++levels] = tail;
+
+	*reached = tail;
+	return levels;
+}
+
+
+// moves the vertices of tmp[0..m-1] to verts[lo..lo+m-1]
+static void nd_place(nd_work *W, int lo, int m) {
+	int k;
+
+	for (k = 0; k < m; k++) {
+		W->verts[lo + k] = W->tmp[k];
+		W->pos[W->tmp[k]] = lo + k;
+	}
+}
+
+
+// orders the subgraph verts[lo..hi-1] by minimum degree
+static int nd_leaf(nd_work *W, int lo, int hi) {
+	int *Gp = W->G->p;
+	int *Gi = W->G->i;
+	int m = hi - lo;
+	int k, p, u, nz;
+	int *q;
+	cs *B;
+
+	if (m < 3)
+		return 1;
+
+	nz = 0;
+	for (k = lo; k < hi; k++) {
+		for (p = Gp[W->verts[k]]; p < Gp[W->verts[k]+1]; p++) {
+			if ((W->pos[Gi[p]] >= lo) && (W->pos[Gi[p]] < hi))
+				nz++;
+		}
+	}
+	B = cs_spalloc(m, m, nz > 0 ? nz : 1, 0, 0);
+	if (B == NULL)
+		return 0;
+	nz = 0;
+	for (k = lo; k < hi; k++) {
+		B->p[k - lo] = nz;
+		for (p = Gp[W->verts[k]]; p < Gp[W->verts[k]+1]; p++) {
+			u = W->pos[Gi[p]];
+			if ((u >= lo) && (u < hi))
+				B->i[nz++] = u - lo;
+		}
+	}
+	B->p[m] = nz;
+
+	q = cs_amd(1, B);
+	cs_spfree(B);
+	if (q == NULL)
+		return 0;
+	for (k = 0; k < m; k++)
+		W->tmp[k] = W->verts[lo + q[k]];
+	nd_place(W, lo, m);
+	cs_free(q);
+	return 1;
+}
+
+
+// splits the subgraph verts[lo..hi-1] into [A | B | S], where the separator S
+// is taken from a level of a breadth first search from a pseudo peripheral
+// vertex. A disconnected subgraph is split into [component | rest] instead.
+// Returns the sizes of the two parts that are dissected further, 0 for a leaf
+static int nd_split(nd_work *W, int lo, int hi, int *a, int *b) {
+	int *Gp = W->G->p;
+	int *Gi = W->G->i;
+	int m = hi - lo;
+	int root, levels, prev_levels, reached, iter, l, k, v, p, deg, min_deg;
+	int best, best_size, na, nb, ns;
+
+	// pseudo peripheral vertex: restart from the least connected vertex
+	// of the last level while the search gets deeper
+	root = W->verts[lo];
+	levels = nd_bfs(W, lo, hi, root, &reached);
+	for (iter = 0; iter < 4; iter++) {
+		min_deg = -1;
+		for (k = W->level_ptr[levels-1]; k < reached; k++) {
+			v = W->queue[k];
+			deg = Gp[v+1] - Gp[v];
+			if ((min_deg == -1) || (deg < min_deg)) {
+				min_deg = deg;
+				root = v;
+			}
+		}
+		prev_levels = levels;
+		levels = nd_bfs(W, lo, hi, root, &reached);
+		if (levels <= prev_levels)
+			break;
+	}
+
+	if (reached < m) {
+		for (k = 0; k < reached; k++)
+			W->tmp[k] = W->queue[k];
+		na = reached;
+		for (k = lo; k < hi; k++) {
+			if (W->level[W->verts[k]] == -1)
+				W->tmp[na++] = W->verts[k];
+		}
+		nd_place(W, lo, m);
+		*a = reached;
+		*b = m - reached;
+		return 1;
+	}
+	if (levels < 3)
+		return 0;
+
+	// smallest level among the balanced ones, else the median level
+	best = -1;
+	best_size = m + 1;
+	for (l = 1; l < levels - 1; l++) {
+		if ((W->level_ptr[l] < ND_SPLIT_MIN * m) || (W->level_ptr[l+1] > (1 - ND_SPLIT_MIN) * m))
+			continue;
+		if (W->level_ptr[l+1] - W->level_ptr[l] < best_size) {
+			best = l;
+			best_size = W->level_ptr[l+1] - W->level_ptr[l];
+		}
+	}
+	if (best == -1) {
+		for (best = 1; (best < levels - 2) && (W->level_ptr[best+1] < m / 2); best++)
+			;
+	}
+
+	// only the vertices of the level that touch the next level separate it
+	na = 0;
+	for (k = 0; k < W->level_ptr[best+1]; k++) {
+		v = W->queue[k];
+		if (W->level[v] == best) {
+			for (p = Gp[v]; p < Gp[v+1]; p++) {
+				if ((W->pos[Gi[p]] >= lo) && (W->pos[Gi[p]] < hi) && (W->level[Gi[p]] == best + 1))
+					break;
+			}
+			if (p < Gp[v+1])
+				continue;
+		}
+		W->tmp[na++] = v;
+	}
+	nb = m - W->level_ptr[best+1];
+	for (k = 0; k < nb; k++)
+		W->tmp[na + k] = W->queue[W->level_ptr[best+1] + k];
+	ns = na + nb;
+	for (k = W->level_ptr[best]; k < W->level_ptr[best+1]; k++) {
+		v = W->queue[k];
+		for (p = Gp[v]; p < Gp[v+1]; p++) {
+			if ((W->pos[Gi[p]] >= lo) && (W->pos[Gi[p]] < hi) && (W->level[Gi[p]] == best + 1)) {
+				W->tmp[ns++] = v;
+				break;
+			}
+		}
+	}
+	nd_place(W, lo, m);
+
+	*a = na;
+	*b = nb;
+	return 1;
+}
+
+
+// nested dissection ordering of A+A'. The subgraphs are split by vertex
+// separators that are ordered after both halves, down to ND_LEAF_SIZE
+// vertices, which are ordered by AMD. Returns the permutation of size n
+// (as cs_amd does) or NULL on error
+int *nd_order(const cs *A) {
+	nd_work W;
+	cs *AT, *G;
+	int *stack;
+	int n, k, top, lo, hi, a, b, ok = 1;
+
+	if (!CS_CSC (A) || (A->m != A->n))
+		return NULL;
+	n = A->n;
+
+	AT = cs_transpose(A, 0);
+	G = AT ? cs_add(A, AT, 0, 0) : NULL;
+	cs_spfree(AT);
+	if ((G == NULL) || (cs_fkeep(G, &cs_diag, NULL) == -1)) {
+		cs_spfree(G);
+		return NULL;
+	}
+
+	W.G = G;
+	W.verts = (int *) cs_malloc(n, sizeof(int));
+	W.pos = (int *) cs_malloc(n, sizeof(int));
+	W.level = (int *) cs_malloc(n, sizeof(int));
+	W.queue = (int *) cs_malloc(n, sizeof(int));
+	W.level_ptr = (int *) cs_malloc(n + 1, sizeof(int));
+	W.tmp = (int *) cs_malloc(n, sizeof(int));
+	stack = (int *) cs_malloc(2 * n + 2, sizeof(int));
+	if (!W.verts || !W.pos || !W.level || !W.queue || !W.level_ptr || !W.tmp || !stack)
+		ok = 0;
+
+	if (ok) {
+		for (k = 0; k < n; k++) {
+			W.verts[k] = k;
+			W.pos[k] = k;
+		}
+
+		top = 0;
+		stack[top++] = 0;
+		stack[top++] = n;
+		while (ok && (top > 0)) {
+			hi = stack[--top];
+			lo = stack[--top];
+			if (hi - lo <= ND_LEAF_SIZE) {
+				ok = nd_leaf(&W, lo, hi);
+			}
+			else if (nd_split(&W, lo, hi, &a, &b)) {
+				if (a > 0) {
+					stack[top++] = lo;
+					stack[top++] = lo + a;
+				}
+				if (b > 0) {
+					stack[top++] = lo + a;
+					stack[top++] = lo + a + b;
+				}
+			}
+			else {
+				ok = nd_leaf(&W, lo, hi);
+			}
+		}
+	}
+
+	cs_spfree(G);
+	cs_free(W.pos);
+	cs_free(W.level);
+	cs_free(W.queue);
+	cs_free(W.level_ptr);
+	cs_free(W.tmp);
+	cs_free(stack);
+	if (!ok)
+		return (cs_free(W.verts));
+	return W.verts;
+}
@@ -0,0 +1,14 @@
+#ifndef _ORDERING_H_
+#define _ORDERING_H_
+
+#include "../csparse/csparse.h"
+
+// subgraphs with fewer vertices are not dissected further, but ordered by AMD
+#define ND_LEAF_SIZE		256
+// the separator is the smallest level of the breadth first search whose
+// vertices split the subgraph between ND_SPLIT_MIN and 1 - ND_SPLIT_MIN
+#define ND_SPLIT_MIN		0.35
+
+extern int *nd_order(const cs *A);
+
+#endif
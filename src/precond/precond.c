@@ -0,0 +1,521 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "precond.h"
+#include "../spmv/spmv.h"
+
+
+cs *ilu_LU = NULL;
+int *ilu_diag = NULL;
+
+amg_level *amg_levels = NULL;
+int amg_levels_num = 0;
+
+// direct factorization of the coarsest level
+css *amg_coarse_S = NULL;
+csn *amg_coarse_N = NULL;
+
+
+// computes the incomplete LU factorization with zero fill-in of A (compressed column form).
+// The diagonal is added to the pattern, so that the voltage source rows of the MNA array
+// (zero diagonal) get their pivot from the elimination of the node rows.
+// For a symmetric A the result is the IC(0) preconditioner, M = L*D*L'.
+// Returns 1 on success, 0 if a zero pivot is met (the factors are freed)
+int ilu0_init(const cs *A) {
+	cs *I = NULL;
+	cs *A_diag = NULL;
+	int *w = NULL;
+	int *Rp, *Ri;
+	double *Rx;
+	double l_ik;
+	int n, i, k, p, q;
+
+	ilu0_free();
+
+	if (A == NULL)
+		return 0;
+
+	n = A->n;
+
+	// A + 0*I
+	I = cs_spalloc(n, n, n, 1, 0);
+	if (I == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < n; i++) {
+		I->p[i] = i;
+		I->i[i] = i;
+		I->x[i] = 1;
+	}
+	I->p[n] = n;
+
+	A_diag = cs_add(A, I, 1, 0);
+	cs_spfree(I);
+	if (A_diag == NULL) {
+		printf("Error in cs_add\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// the transpose has the rows of A with sorted column indices
+	ilu_LU = cs_transpose(A_diag, 1);
+	cs_spfree(A_diag);
+
+	ilu_diag = (int *) malloc(n*sizeof(int));
+	w = (int *) malloc(n*sizeof(int));
+	if ((ilu_LU == NULL) || (ilu_diag == NULL) || (w == NULL)) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+
+	Rp = ilu_LU->p;
+	Ri = ilu_LU->i;
+	Rx = ilu_LU->x;
+
+	for (i = 0; i < n; i++) {
+		w[i] = -1;
+		for (p = Rp[i]; p < Rp[i+1]; p++) {
+			if (Ri[p] == i)
+				ilu_diag[i] = p;
+		}
+	}
+
+	// IKJ variant: row i is updated by the previous rows k that appear in its pattern
+	for (i = 0; i < n; i++) {
+		for (p = Rp[i]; p < Rp[i+1]; p++)
+			w[Ri[p]] = p;
+
+		for (p = Rp[i]; p < ilu_diag[i]; p++) {
+			k = Ri[p];
+			l_ik = Rx[p] / Rx[ilu_diag[k]];
+			Rx[p] = l_ik;
+
+			// no fill-in: only entries present in the pattern of row i are updated
+			for (q = ilu_diag[k] + 1; q < Rp[k+1]; q++) {
+				if (w[Ri[q]] != -1)
+					Rx[w[Ri[q]]] -= l_ik * Rx[q];
+			}
+		}
+
+		for (p = Rp[i]; p < Rp[i+1]; p++)
+			w[Ri[p]] = -1;
+
+		if (Rx[ilu_diag[i]] == 0) {
+			free(w);
+			ilu0_free();
+			return 0;
+		}
+	}
+
+	free(w);
+	return 1;
+}
+
+
+// z = (L*U)^-1 * r
+void ilu0_solve(const double *r, double *z) {
+	int *Rp = ilu_LU->p;
+	int *Ri = ilu_LU->i;
+	double *Rx = ilu_LU->x;
+	int n = ilu_LU->n;
+	int i, p;
+	double sum;
+
+	// L*y = r (unit diagonal)
+	for (i = 0; i < n; i++) {
+		sum = r[i];
+		for (p = Rp[i]; p < ilu_diag[i]; p++)
+			sum -= Rx[p] * z[Ri[p]];
+		z[i] = sum;
+	}
+
+	// U*z = y
+	for (i = n-1; i >= 0; i--) {
+		sum = z[i];
+		for (p = ilu_diag[i] + 1; p < Rp[i+1]; p++)
+			sum -= Rx[p] * z[Ri[p]];
+		z[i] = sum / Rx[ilu_diag[i]];
+	}
+}
+
+
+// z = (L*U)^-T * r, used by Bi-CG for the transposed system
+void ilu0_transpose_solve(const double *r, double *z) {
+	int *Rp = ilu_LU->p;
+	int *Ri = ilu_LU->i;
+	double *Rx = ilu_LU->x;
+	int n = ilu_LU->n;
+	int i, p;
+
+	memcpy(z, r, n*sizeof(double));
+
+	// U'*y = r (row i of U is column i of U')
+	for (i = 0; i < n; i++) {
+		z[i] = z[i] / Rx[ilu_diag[i]];
+		for (p = ilu_diag[i] + 1; p < Rp[i+1]; p++)
+			z[Ri[p]] -= Rx[p] * z[i];
+	}
+
+	// L'*z = y (unit diagonal)
+	for (i = n-1; i >= 0; i--) {
+		for (p = Rp[i]; p < ilu_diag[i]; p++)
+			z[Ri[p]] -= Rx[p] * z[i];
+	}
+}
+
+
+void ilu0_free() {
+	if (ilu_LU)
+		cs_spfree(ilu_LU);
+	ilu_LU = NULL;
+
+	free(ilu_diag);
+	ilu_diag = NULL;
+}
+
+
+// groups the nodes of A into aggregates of strongly connected neighbours.
+// Returns the number of aggregates and stores the aggregate of each node into agg
+int amg_aggregate(const cs *A, const double *diag, int *agg) {
+	int *Ap = A->p;
+	int *Ai = A->i;
+	double *Ax = A->x;
+	int n = A->n;
+	int *pass1 = NULL;
+	int i, p, j, nc = 0;
+	int free_nbrs;
+
+	pass1 = (int *) malloc(n*sizeof(int));
+	if (pass1 == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0; i < n; i++)
+		agg[i] = -1;
+
+	// pass 1: a node with no aggregated strong neighbours starts an aggregate with all of them
+	for (i = 0; i < n; i++) {
+		if (agg[i] != -1)
+			continue;
+
+		free_nbrs = 1;
+		for (p = Ap[i]; p < Ap[i+1]; p++) {
+			j = Ai[p];
+			if ((j != i) && (fabs(Ax[p]) >= AMG_THETA*sqrt(diag[i]*diag[j])) && (agg[j] != -1)) {
+				free_nbrs = 0;
+				break;
+			}
+		}
+		if (!free_nbrs)
+			continue;
+
+		agg[i] = nc;
+		for (p = Ap[i]; p < Ap[i+1]; p++) {
+			j = Ai[p];
+			if ((j != i) && (fabs(Ax[p]) >= AMG_THETA*sqrt(diag[i]*diag[j])))
+				agg[j] = nc;
+		}
+		nc++;
+	}
+
+	// pass 2: the remaining nodes join the aggregate of a strong neighbour
+	memcpy(pass1, agg, n*sizeof(int));
+	for (i = 0; i < n; i++) {
+		if (agg[i] != -1)
+			continue;
+
+		for (p = Ap[i]; p < Ap[i+1]; p++) {
+			j = Ai[p];
+			if ((j != i) && (fabs(Ax[p]) >= AMG_THETA*sqrt(diag[i]*diag[j])) && (pass1[j] != -1)) {
+				agg[i] = pass1[j];
+				break;
+			}
+		}
+	}
+
+	// pass 3: whatever is left forms aggregates with its unaggregated strong neighbours
+	for (i = 0; i < n; i++) {
+		if (agg[i] != -1)
+			continue;
+
+		agg[i] = nc;
+		for (p = Ap[i]; p < Ap[i+1]; p++) {
+			j = Ai[p];
+			if ((j != i) && (fabs(Ax[p]) >= AMG_THETA*sqrt(diag[i]*diag[j])) && (agg[j] == -1))
+				agg[j] = nc;
+		}
+		nc++;
+	}
+
+	free(pass1);
+	return nc;
+}
+
+
+// builds the smoothed prolongator P = (I - omega*D^-1*A)*T, where T is the
+// piecewise constant (tentative) prolongator of the aggregates
+cs *amg_prolongator(const cs *A, const double *inv_diag, const int *agg, int nc) {
+	cs *T = NULL;
+	cs *AT = NULL;
+	cs *P = NULL;
+	int *agg_size = NULL;
+	int n = A->n;
+	int i, j, p;
+	double rho = 0, row_sum, omega;
+
+	agg_size = (int *) calloc(nc + 1, sizeof(int));
+	T = cs_spalloc(n, nc, n, 1, 0);
+	if ((agg_size == NULL) || (T == NULL)) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// column c of T holds the nodes of aggregate c (scaled to unit norm)
+	for (i = 0; i < n; i++)
+		agg_size[agg[i]]++;
+	cs_cumsum(T->p, agg_size, nc);
+	for (i = 0; i < n; i++) {
+		p = agg_size[agg[i]]++;
+		T->i[p] = i;
+	}
+	for (j = 0; j < nc; j++) {
+		for (p = T->p[j]; p < T->p[j+1]; p++)
+			T->x[p] = 1.0/sqrt(T->p[j+1] - T->p[j]);
+	}
+	free(agg_size);
+
+	// Gershgorin bound of the spectral radius of D^-1*A (A is symmetric, so columns are rows)
+	for (j = 0; j < n; j++) {
+		row_sum = 0;
+		for (p = A->p[j]; p < A->p[j+1]; p++)
+			row_sum += fabs(A->x[p]);
+		rho = CS_MAX(rho, row_sum*inv_diag[j]);
+	}
+	omega = (4.0/3.0)/rho;
+
+	AT = cs_multiply(A, T);
+	if (AT == NULL) {
+		printf("Error in cs_multiply\n");
+		exit(EXIT_FAILURE);
+	}
+	for (j = 0; j < nc; j++) {
+		for (p = AT->p[j]; p < AT->p[j+1]; p++)
+			AT->x[p] *= inv_diag[AT->i[p]];
+	}
+
+	P = cs_add(T, AT, 1, -omega);
+	if (P == NULL) {
+		printf("Error in cs_add\n");
+		exit(EXIT_FAILURE);
+	}
+
+	cs_spfree(T);
+	cs_spfree(AT);
+	return P;
+}
+
+
+// computes the smoothed aggregation AMG hierarchy of A (symmetric with a positive diagonal,
+// like the resistive grids of power grid analysis).
+// Returns AMG_OK, or the reason it failed (the hierarchy is freed then)
+int amg_init(const cs *A) {
+	amg_level *lvl;
+	cs *AP = NULL;
+	double *diag = NULL;
+	int *agg = NULL;
+	int n, nc, i, p;
+
+	amg_free();
+
+	if (A == NULL)
+		return AMG_NO_COARSE;
+
+	amg_levels = (amg_level *) calloc(AMG_MAX_LEVELS, sizeof(amg_level));
+	if (amg_levels == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// the finest level keeps a copy, as A changes between the DC and the transient arrays
+	amg_levels[0].A = cs_add(A, A, 1, 0);
+	if (amg_levels[0].A == NULL) {
+		printf("Error in cs_add\n");
+		exit(EXIT_FAILURE);
+	}
+	amg_levels_num = 1;
+
+	while (1) {
+		lvl = &amg_levels[amg_levels_num - 1];
+		n = lvl->A->n;
+
+		lvl->x = (double *) calloc(n, sizeof(double));
+		lvl->b = (double *) calloc(n, sizeof(double));
+		lvl->r = (double *) calloc(n, sizeof(double));
+		lvl->inv_diag = (double *) calloc(n, sizeof(double));
+		diag = (double *) calloc(n, sizeof(double));
+		if ((lvl->x == NULL) || (lvl->b == NULL) || (lvl->r == NULL) || (lvl->inv_diag == NULL) || (diag == NULL)) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (i = 0; i < n; i++) {
+			for (p = lvl->A->p[i]; p < lvl->A->p[i+1]; p++) {
+				if (lvl->A->i[p] == i)
+					diag[i] += lvl->A->x[p];
+			}
+
+			// the Jacobi smoother needs a positive diagonal
+			if (diag[i] <= 0) {
+				free(diag);
+				amg_free();
+				return AMG_BAD_DIAG;
+			}
+			lvl->inv_diag[i] = 1.0/diag[i];
+		}
+
+		if ((n <= AMG_COARSE_SIZE) || (amg_levels_num == AMG_MAX_LEVELS)) {
+			free(diag);
+			break;
+		}
+
+		agg = (int *) malloc(n*sizeof(int));
+		if (agg == NULL) {
+			printf("Error. Memory allocation problems. Exiting..\n");
+			exit(EXIT_FAILURE);
+		}
+
+		nc = amg_aggregate(lvl->A, diag, agg);
+		free(diag);
+
+		// coarsening has stalled, solve this level directly
+		if (nc >= n) {
+			free(agg);
+			break;
+		}
+
+		lvl->P = amg_prolongator(lvl->A, lvl->inv_diag, agg, nc);
+		lvl->R = cs_transpose(lvl->P, 1);
+		free(agg);
+
+		// Galerkin coarse array R*A*P
+		AP = cs_multiply(lvl->A, lvl->P);
+		if ((lvl->R == NULL) || (AP == NULL)) {
+			printf("Error in cs_multiply\n");
+			exit(EXIT_FAILURE);
+		}
+		amg_levels[amg_levels_num].A = cs_multiply(lvl->R, AP);
+		cs_spfree(AP);
+		if (amg_levels[amg_levels_num].A == NULL) {
+			printf("Error in cs_multiply\n");
+			exit(EXIT_FAILURE);
+		}
+		amg_levels_num++;
+	}
+
+	lvl = &amg_levels[amg_levels_num - 1];
+	amg_coarse_S = cs_sqr(2, lvl->A, 0);
+	amg_coarse_N = cs_lu(lvl->A, amg_coarse_S, 1);
+	if ((amg_coarse_S == NULL) || (amg_coarse_N == NULL)) {
+		amg_free();
+		return AMG_NO_COARSE;
+	}
+
+	printf("AMG levels: %d (", amg_levels_num);
+	for (i = 0; i < amg_levels_num; i++)
+		printf("%d%s", amg_levels[i].A->n, (i == amg_levels_num-1)?")\n":", ");
+
+	return AMG_OK;
+}
+
+
+// r = b - A*x. The level arrays are symmetric, so A is multiplied as A'
+void amg_residual(const cs *A, const double *x, const double *b, double *r) {
+
+	memcpy(r, b, A->n*sizeof(double));
+	spmv_transpose(A, -1.0, x, 1.0, r);
+}
+
+
+// damped Jacobi sweeps on A*x = b
+void amg_smooth(amg_level *lvl) {
+	int i, k;
+
+	for (k = 0; k < AMG_SMOOTH_STEPS; k++) {
+		amg_residual(lvl->A, lvl->x, lvl->b, lvl->r);
+		for (i = 0; i < lvl->A->n; i++)
+			lvl->x[i] += AMG_JACOBI_WEIGHT * lvl->inv_diag[i] * lvl->r[i];
+	}
+}
+
+
+// V-cycle starting from a zero guess. Level l solves A_l*x = b_l
+void amg_vcycle(int l) {
+	amg_level *lvl = &amg_levels[l];
+	amg_level *coarse;
+	int n = lvl->A->n;
+
+	if (l == amg_levels_num - 1) {
+		cs_ipvec(amg_coarse_N->pinv, lvl->b, lvl->r, n);
+		cs_lsolve(amg_coarse_N->L, lvl->r);
+		cs_usolve(amg_coarse_N->U, lvl->r);
+		cs_ipvec(amg_coarse_S->q, lvl->r, lvl->x, n);
+		return;
+	}
+
+	coarse = &amg_levels[l+1];
+
+	memset(lvl->x, 0, n*sizeof(double));
+	amg_smooth(lvl);
+
+	// restrict the residual
+	amg_residual(lvl->A, lvl->x, lvl->b, lvl->r);
+	// R*r = P'*r
+	spmv_transpose(lvl->P, 1.0, lvl->r, 0.0, coarse->b);
+
+	amg_vcycle(l+1);
+
+	// x = x + P*x_coarse = x + R'*x_coarse
+	spmv_transpose(lvl->R, 1.0, coarse->x, 1.0, lvl->x);
+
+	amg_smooth(lvl);
+}
+
+
+// z = M^-1 * r, where M^-1 is one V-cycle. The same number of Jacobi sweeps
+// before and after the coarse correction keeps it symmetric, as required by CG
+void amg_solve(const double *r, double *z) {
+	memcpy(amg_levels[0].b, r, amg_levels[0].A->n*sizeof(double));
+	amg_vcycle(0);
+	memcpy(z, amg_levels[0].x, amg_levels[0].A->n*sizeof(double));
+}
+
+
+void amg_free() {
+	int i;
+
+	for (i = 0; i < amg_levels_num; i++) {
+		if (amg_levels[i].A)
+			cs_spfree(amg_levels[i].A);
+		if (amg_levels[i].P)
+			cs_spfree(amg_levels[i].P);
+		if (amg_levels[i].R)
+			cs_spfree(amg_levels[i].R);
+		free(amg_levels[i].inv_diag);
+		free(amg_levels[i].x);
+		free(amg_levels[i].b);
+		free(amg_levels[i].r);
+	}
+	free(amg_levels);
+	amg_levels = NULL;
+	amg_levels_num = 0;
+
+	if (amg_coarse_S)
+		cs_sfree(amg_coarse_S);
+	amg_coarse_S = NULL;
+	if (amg_coarse_N)
+		cs_nfree(amg_coarse_N);
+	amg_coarse_N = NULL;
+}
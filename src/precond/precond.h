@@ -0,0 +1,46 @@
+#ifndef _PRECOND_H_
+#define _PRECOND_H_
+
+#include "../csparse/csparse.h"
+
+// ILU(0) factors of the MNA array, stored by rows (compressed column form of A transposed).
+// L is unit lower triangular and U upper triangular, both in the pattern of A plus its diagonal
+extern cs *ilu_LU;
+extern int *ilu_diag;	// position of the diagonal entry of each row inside ilu_LU
+
+// smoothed aggregation AMG parameters
+#define AMG_MAX_LEVELS		10
+#define AMG_COARSE_SIZE		50		// size under which a level is solved directly
+#define AMG_THETA			0.08	// strength of connection threshold
+#define AMG_SMOOTH_STEPS	2		// damped Jacobi sweeps before and after the coarse correction
+#define AMG_JACOBI_WEIGHT	(2.0/3.0)
+
+// results of amg_init
+#define AMG_OK				0
+#define AMG_BAD_DIAG		1		// a level has a non positive diagonal entry
+#define AMG_NO_COARSE		2		// the LU of the coarsest level failed (or there is no array)
+
+// one level of the AMG hierarchy. The last level has no P and R
+typedef struct amg_level {
+	cs *A;
+	cs *P;			// prolongator to this level from the next (coarser) one
+	cs *R;			// restriction (P')
+	double *inv_diag;
+	double *x;		// workspace vectors of the level size
+	double *b;
+	double *r;
+} amg_level;
+
+extern amg_level *amg_levels;
+extern int amg_levels_num;
+
+extern int ilu0_init(const cs *A);
+extern void ilu0_solve(const double *r, double *z);
+extern void ilu0_transpose_solve(const double *r, double *z);
+extern void ilu0_free();
+
+extern int amg_init(const cs *A);
+extern void amg_solve(const double *r, double *z);
+extern void amg_free();
+
+#endif
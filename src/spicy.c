@@ -10,16 +10,27 @@
 #include "hashtable/hashtable.h"
 #include "cir_parser/cir_parser.h"
 #include "mna/mna.h"
+#include "precond/precond.h"
+#include "spmv/spmv.h"
+#include "netcache/netcache.h"
 
 
 int main(int argc, char *argv[]) {
 	char gnd_name[2] = "0";
 	char filename[BUF_MAX];
 	unsigned long components_num;
+	byte use_cache = 0;
+
+	// -cache: reuse (or write) the compiled netlist of the file
+	if ((argc == 3) && (strcmp(argv[1], "-cache") == 0)) {
+		use_cache = 1;
+		argv++;
+		argc--;
+	}
 
 	if (argc != 2) {
 		printf("Error. Invalid number of arguments..\n");
-		printf("Use: %s <filename>\n", argv[0]);
+		printf("Use: %s [-cache] <filename>\n", argv[0]);
 		return 1;
 	}
 
@@ -33,16 +44,21 @@ int main(int argc, char *argv[]) {
 
 	strcpy(filename, argv[1]);
 
-	components_num = get_components_num(filename);
-	ht_init(components_num >> 1);
+	// the node table grows while the netlist is read in a single pass
+	ht_init(HT_INIT_SIZE);
 
 	// add grounding into the hash table (we want it to be reserved)
 	ht_put(gnd_name, 0);
 
 	init_lists();
 
+	if (!use_cache || !nc_load(filename, &components_num)) {
+		nc_recording = use_cache;
+		components_num = parse_cir(filename);
+		if (use_cache)
+			nc_save(filename, components_num);
+	}
 	printf("Total number of components: %lu\n\n", components_num);
-	parse_cir(filename);
 
 	printHastable();
 	print_id_list();
@@ -58,9 +74,20 @@ int main(int argc, char *argv[]) {
 	printf("\nSOLVER: %s\n", ((solver_type==0)?"lu_decomp":
 						   ((solver_type == 1)?"cholesky_decomp":
 						   ((solver_type == 2)?"cg_solver":
-						   ((solver_type == 3)?"bi_cg_solver":"unknown_solver")))));
+						   ((solver_type == 3)?"bi_cg_solver":
+						   ((solver_type == 4)?"bicgstab_solver":
+						   ((solver_type == 5)?"gmres_solver":"unknown_solver")))))));
+	if (solver_type == GMRES_SOLVER)
+		printf("GMRES_RESTART: %u\n", gmres_restart);
+	if ((solver_type == CG_SOLVER) || IS_NONSYM_ITER(solver_type))
+		printf("PRECONDITIONER: %s\n", (precond_type == ILU0_PRECOND)?"ILU0":
+											 ((precond_type == AMG_PRECOND)?"AMG":"JACOBI"));
+	if (spmv_threads > 0)
+		printf("THREADS: %d\n", spmv_threads);
 	printf("ITOL: %e\n", itol);
 	printf("%sSPARSE\n", is_sparse?"":"NOT ");
+	if (is_sparse && ((solver_type == LU_SOLVER) || (solver_type == CHOL_SOLVER)))
+		printf("ORDERING: %s\n", (order_type == ORDER_ND)?"ND":"AMD");
 	printf("%sTRANSIENT ANALYSIS\n", is_trans?"":"NO ");
 	if (is_trans) {
 		printf("TRANSIENT_METHOD: %s\n", (tr_method == TRAPEZOIDAL)?"TRAPEZOIDAL":"BACKWARD_EULER");
@@ -82,6 +109,10 @@ int main(int argc, char *argv[]) {
 			// NOTE create_compressed_column() must always be called before that
 			// function create_G() allocates memory for G
 			create_G();
+
+			// the DC array gets the pattern of G + factor*C, so that the
+			// symbolic analysis is shared by the DC and transient arrays
+			reset_MNA_array();
 		}
 
 	}
@@ -109,6 +140,8 @@ int main(int argc, char *argv[]) {
 		// iterative solving method. No need to decompose
 		case CG_SOLVER:
 		case BI_CG_SOLVER:
+		case BICGSTAB_SOLVER:
+		case GMRES_SOLVER:
 			gsl_x_vector = gsl_vector_calloc(mna_dimension_size);
 			initialise_iter_methods();
 			break;
@@ -143,6 +176,16 @@ int main(int argc, char *argv[]) {
 			solve_BI_CG_iter_method();
 			/*free_gsl_vectors();*/
 			break;
+		case BICGSTAB_SOLVER:
+
+			solve_BICGSTAB_iter_method();
+			/*free_gsl_vectors();*/
+			break;
+		case GMRES_SOLVER:
+
+			solve_GMRES_iter_method();
+			/*free_gsl_vectors();*/
+			break;
 		default:
 			break;
 	}
@@ -173,6 +216,8 @@ int main(int argc, char *argv[]) {
 
 
 	free_gsl_vectors();
+	ilu0_free();
+	amg_free();
 	free_MNA_system();
 	freeHashTable();
 	free_lists();
@@ -182,19 +227,24 @@ int main(int argc, char *argv[]) {
 
 	if (css_S)
 		cs_sfree(css_S);
+	if (css_S_pattern)
+		cs_spfree(css_S_pattern);
+	super_sym_free(super_Y);
 	if (csn_N)
 		cs_nfree(csn_N);
+	tri_sched_free(tri_L);
+	tri_sched_free(tri_U);
 	if (compr_col_A)
 		cs_spfree(compr_col_A);
 	if (compr_col_C)
 		cs_spfree(compr_col_C);
 	if (compr_col_G)
 		cs_spfree(compr_col_G);
+	if (compr_row_H)
+		cs_spfree(compr_row_H);
 
-	if (p_vector)
-		free(p_vector);
-	if (q_vector)
-		free(q_vector);
+	if (compr_col_AT)
+		cs_spfree(compr_col_AT);
 
 
 	return 0;
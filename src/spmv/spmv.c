@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "spmv.h"
+
+
+int spmv_threads = 0;
+
+
+// returns the number of threads the kernels will use
+int spmv_get_threads() {
+#ifdef _OPENMP
+	if (spmv_threads > 0)
+		return spmv_threads;
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+
+// returns the first column of partition part, when the columns of A are split into
+// parts with about the same number of nonzeros (binary search on the column pointers)
+int spmv_part_start(const cs *A, int part, int parts) {
+	long target;
+	int lo, hi, mid;
+
+	if (part <= 0)
+		return 0;
+	if (part >= parts)
+		return A->n;
+
+	target = ((long) A->p[A->n] * part) / parts;
+
+	// first column j with p[j] >= target
+	lo = 0;
+	hi = A->n;
+	while (lo < hi) {
+		mid = lo + (hi - lo)/2;
+		if (A->p[mid] < target)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+
+// y = alpha*A'*x + beta*y for A in compressed column form.
+// Column j of A is row j of A', so each y[j] is one dot product: the threads
+// write disjoint parts of y and need no synchronisation. A*x is computed by
+// passing the compressed column form of A' (the rows of A).
+// y is not read when beta is zero
+void spmv_transpose(const cs *A, double alpha, const double *x, double beta, double *y) {
+	int *Ap = A->p;
+	int *Ai = A->i;
+	double *Ax = A->x;
+	int parts = 1;
+
+#ifdef _OPENMP
+	if (A->p[A->n] >= SPMV_PAR_MIN_NNZ)
+		parts = spmv_get_threads();
+#endif
+
+	#pragma omp parallel num_threads(parts) if (parts > 1)
+	{
+		int part = 0;
+		int nparts = 1;
+		int j, p, start, end;
+		double sum;
+
+#ifdef _OPENMP
+		part = omp_get_thread_num();
+		nparts = omp_get_num_threads();
+#endif
+		start = spmv_part_start(A, part, nparts);
+		end = spmv_part_start(A, part + 1, nparts);
+
+		for (j = start; j < end; j++) {
+			sum = 0.0;
+			for (p = Ap[j]; p < Ap[j+1]; p++) {
+				sum += Ax[p] * x[Ai[p]];
+			}
+
+			if (beta == 0.0)
+				y[j] = alpha*sum;
+			else
+				y[j] = alpha*sum + beta*y[j];
+		}
+	}
+}
+
+
+// Y = A'*X for k right-hand sides. X and Y are stored by rows (entry (i, c)
+// at [i*k + c]), so every nonzero of A is loaded once for all k columns
+void spmm_transpose(const cs *A, int k, const double *X, double *Y) {
+	int *Ap = A->p;
+	int *Ai = A->i;
+	double *Ax = A->x;
+	int parts = 1;
+
+#ifdef _OPENMP
+	if ((long) A->p[A->n] * k >= SPMV_PAR_MIN_NNZ)
+		parts = spmv_get_threads();
+#endif
+
+	#pragma omp parallel num_threads(parts) if (parts > 1)
+	{
+		int part = 0;
+		int nparts = 1;
+		int j, p, c, start, end;
+		const double *x;
+		double *y;
+		double a;
+
+#ifdef _OPENMP
+		part = omp_get_thread_num();
+		nparts = omp_get_num_threads();
+#endif
+		start = spmv_part_start(A, part, nparts);
+		end = spmv_part_start(A, part + 1, nparts);
+
+		for (j = start; j < end; j++) {
+			y = &Y[(long) j*k];
+			for (c = 0; c < k; c++)
+				y[c] = 0.0;
+
+			for (p = Ap[j]; p < Ap[j+1]; p++) {
+				a = Ax[p];
+				x = &X[(long) Ai[p]*k];
+				for (c = 0; c < k; c++)
+					y[c] += a * x[c];
+			}
+		}
+	}
+}
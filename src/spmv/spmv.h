@@ -0,0 +1,17 @@
+#ifndef _SPMV_H_
+#define _SPMV_H_
+
+#include "../csparse/csparse.h"
+
+// matrices with fewer nonzeros are multiplied by a single thread
+#define SPMV_PAR_MIN_NNZ	20000
+
+// number of threads used by the kernels (0: OpenMP default, .OPTIONS THREADS=<n>)
+extern int spmv_threads;
+
+extern int spmv_get_threads();
+extern int spmv_part_start(const cs *A, int part, int parts);
+extern void spmv_transpose(const cs *A, double alpha, const double *x, double beta, double *y);
+extern void spmm_transpose(const cs *A, int k, const double *X, double *Y);
+
+#endif
@@ -0,0 +1,589 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <gsl/gsl_blas.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "supernodal.h"
+#include "../spmv/spmv.h"
+
+
+// groups the columns of L into relaxed supernodes. Column j joins the
+// supernode of column j-1 when it is its parent in the elimination tree, so
+// the pattern of every column of the supernode is contained in the rows of
+// its last column plus the diagonal block
+static int super_partition(int n, const int *parent, const int *cp, int *sup_ptr) {
+	int j, f = 0, w, m, supers_num = 0;
+	double dense, exact = 0, zeros;
+
+	sup_ptr[0] = 0;
+	for (j = 0; j < n; j++) {
+		if ((j > 0) && (parent[j-1] == j)) {
+			w = j - f + 1;
+			m = j - f + cp[j+1] - cp[j];
+			dense = (double)w * m - (double)w * (w - 1) / 2;
+			zeros = dense - (exact + cp[j+1] - cp[j]);
+			if ((zeros == 0) || (w <= SUPER_RELAX_WIDTH) || (zeros <= SUPER_RELAX_ZEROS * dense)) {
+				exact += cp[j+1] - cp[j];
+				continue;
+			}
+		}
+		// column j starts a new supernode
+		if (j > 0)
+			sup_ptr[++supers_num] = j;
+		f = j;
+		exact = cp[j+1] - cp[j];
+	}
+	sup_ptr[++supers_num] = n;
+	return supers_num;
+}
+
+
+// nonzero pattern of L, row by row from the elimination tree (as in cs_chol)
+static cs *super_pattern(const cs *C, const css *S) {
+	int n = C->n;
+	int *c, *s, *Li;
+	int k, top, p;
+	cs *L;
+
+	L = cs_spalloc(n, n, S->cp[n], 1, 0);
+	c = (int *) cs_malloc(2 * n, sizeof(int));
+	if (!L || !c) {
+		cs_free(c);
+		return (cs_spfree(L));
+	}
+	s = c + n;
+	Li = L->i;
+	for (k = 0; k <= n; k++)
+		L->p[k] = S->cp[k];
+	for (k = 0; k < n; k++)
+		c[k] = S->cp[k];
+	for (k = 0; k < n; k++) {
+		top = cs_ereach(C, k, S->parent, s, c);
+		for (; top < n; top++)
+			Li[c[s[top]]++] = k;
+		p = c[k]++;
+		Li[p] = k;
+	}
+	cs_free(c);
+	return L;
+}
+
+
+void super_sym_free(super_sym *Y) {
+
+	if (Y == NULL)
+		return;
+	cs_free(Y->sup_ptr);
+	cs_free(Y->col2sup);
+	cs_free(Y->rows_ptr);
+	cs_free(Y->rows);
+	cs_free(Y->x_ptr);
+	cs_free(Y->sup_parent);
+	cs_spfree(Y->L);
+	free(Y);
+}
+
+
+// symbolic analysis of the supernodal factorization of A(p,p), on top of
+// the elimination tree and column counts of cs_schol
+super_sym *super_analyze(const cs *A, const css *S) {
+	super_sym *Y;
+	cs *C;
+	int n, s, j, f, l, p, q, rows_size;
+	double x_size;
+
+	if (!CS_CSC (A) || !S || !S->cp || !S->parent)
+		return NULL;
+	n = A->n;
+
+	Y = (super_sym *) cs_calloc(1, sizeof(super_sym));
+	if (Y == NULL)
+		return NULL;
+	Y->n = n;
+	Y->sup_ptr = (int *) cs_malloc(n + 1, sizeof(int));
+	Y->col2sup = (int *) cs_malloc(n, sizeof(int));
+	C = cs_symperm(A, S->pinv, 0);
+	if (!Y->sup_ptr || !Y->col2sup || !C) {
+		cs_spfree(C);
+		super_sym_free(Y);
+		return NULL;
+	}
+	Y->L = super_pattern(C, S);
+	cs_spfree(C);
+	if (Y->L == NULL) {
+		super_sym_free(Y);
+		return NULL;
+	}
+
+	Y->supers_num = super_partition(n, S->parent, S->cp, Y->sup_ptr);
+
+	// rows of supernode s: its own columns, then the rows of its last column
+	Y->rows_ptr = (int *) cs_malloc(Y->supers_num + 1, sizeof(int));
+	Y->x_ptr = (int *) cs_malloc(Y->supers_num + 1, sizeof(int));
+	if (!Y->rows_ptr || !Y->x_ptr) {
+		super_sym_free(Y);
+		return NULL;
+	}
+	rows_size = 0;
+	x_size = 0;
+	for (s = 0; s < Y->supers_num; s++) {
+		f = Y->sup_ptr[s];
+		l = Y->sup_ptr[s+1] - 1;
+		Y->rows_ptr[s] = rows_size;
+		Y->x_ptr[s] = (int) x_size;
+		p = (l - f) + S->cp[l+1] - S->cp[l];
+		rows_size += p;
+		x_size += (double)p * (l - f + 1);
+		for (j = f; j <= l; j++)
+			Y->col2sup[j] = s;
+	}
+	if (x_size > (double) INT_MAX) {
+		super_sym_free(Y);
+		return NULL;
+	}
+	Y->rows_ptr[s] = rows_size;
+	Y->x_ptr[s] = (int) x_size;
+	Y->x_size = (int) x_size;
+
+	Y->rows = (int *) cs_malloc(rows_size, sizeof(int));
+	Y->sup_parent = (int *) cs_malloc(Y->supers_num, sizeof(int));
+	if (!Y->rows || !Y->sup_parent) {
+		super_sym_free(Y);
+		return NULL;
+	}
+	for (s = 0; s < Y->supers_num; s++) {
+		f = Y->sup_ptr[s];
+		l = Y->sup_ptr[s+1] - 1;
+		q = Y->rows_ptr[s];
+		for (j = f; j < l; j++)
+			Y->rows[q++] = j;
+		for (p = Y->L->p[l]; p < Y->L->p[l+1]; p++)
+			Y->rows[q++] = Y->L->i[p];
+		Y->sup_parent[s] = (S->parent[l] == -1) ? -1 : Y->col2sup[S->parent[l]];
+	}
+
+	return Y;
+}
+
+
+// X(0:w-1, 0:w-1) = chol(X(0:w-1, 0:w-1)) in place, lower triangle
+// (X row major with leading dimension w). Returns 0 if not positive definite
+static int super_dense_chol(double *X, int w) {
+	int i, j, k;
+	double d;
+
+	for (j = 0; j < w; j++) {
+		d = X[j*w + j];
+		for (k = 0; k < j; k++)
+			d -= X[j*w + k] * X[j*w + k];
+		if (d <= 0)
+			return 0;
+		d = sqrt(d);
+		X[j*w + j] = d;
+		for (i = j + 1; i < w; i++) {
+			double t = X[i*w + j];
+			for (k = 0; k < j; k++)
+				t -= X[i*w + k] * X[j*w + k];
+			X[i*w + j] = t / d;
+		}
+	}
+	return 1;
+}
+
+
+// state of a numeric factorization, shared by the tasks
+typedef struct super_num {
+	const super_sym *Y;
+	const cs *C;		// lower triangle of A(p,p)
+	double *X;			// dense blocks of all the supernodes
+	int *head;			// descendants waiting to update each supernode
+	int *next;
+	int *pos;			// next row of each supernode still to be applied
+	int *owner;			// task subtree of each supernode, -1: shared (top of the tree)
+	int parallel;
+	int failed;
+} super_num;
+
+
+// links descendant d to the list of the supernode holding row pos[d]
+static void super_link(super_num *U, int d) {
+	int r = U->Y->col2sup[U->Y->rows[U->pos[d]]];
+
+	if (U->parallel && (U->owner[r] == -1)) {
+		#pragma omp critical (super_link)
+		{
+			U->next[d] = U->head[r];
+			U->head[r] = d;
+		}
+	}
+	else {
+		U->next[d] = U->head[r];
+		U->head[r] = d;
+	}
+}
+
+
+// computes the columns of supernode s, once all of its descendants are done.
+// relmap (n) and W are workspaces of the calling thread.
+// Returns 0 if the array is not positive definite
+static int super_node(super_num *U, int s, int *relmap, double *W) {
+	const super_sym *Y = U->Y;
+	int *Cp = U->C->p;
+	int *Ci = U->C->i;
+	double *Cx = U->C->x;
+	int *rows = Y->rows;
+	int f, l, w, m, d, wd, md, p, q, pe, i, j, k, k1, k2, r;
+	double *Xs, *Xd;
+	gsl_matrix_view Dv, D1v, Wv, L11v, Bv;
+
+	f = Y->sup_ptr[s];
+	l = Y->sup_ptr[s+1] - 1;
+	w = l - f + 1;
+	m = Y->rows_ptr[s+1] - Y->rows_ptr[s];
+	Xs = U->X + Y->x_ptr[s];
+
+	for (i = 0; i < m; i++)
+		relmap[rows[Y->rows_ptr[s] + i]] = i;
+
+	// assemble columns f..l of C (both triangles of the diagonal block)
+	for (j = f; j <= l; j++) {
+		for (p = Cp[j]; p < Cp[j+1]; p++) {
+			i = relmap[Ci[p]];
+			Xs[i*w + (j - f)] = Cx[p];
+			if (i < w)
+				Xs[(j - f)*w + i] = Cx[p];
+		}
+	}
+
+	// updates of the descendants with rows inside f..l
+	for (d = U->head[s]; d != -1; d = k) {
+		k = U->next[d];
+		wd = Y->sup_ptr[d+1] - Y->sup_ptr[d];
+		md = Y->rows_ptr[d+1];
+		Xd = U->X + Y->x_ptr[d];
+		p = U->pos[d];
+		for (q = p; (q < md) && (rows[q] <= l); q++)
+			;
+		k1 = q - p;
+		k2 = md - p;
+		// rows p.. of d start at row p - rows_ptr[d] of its block
+		pe = p - Y->rows_ptr[d];
+
+		if ((double)k1 * k2 * wd < SUPER_GEMM_MIN_FLOPS) {
+			for (i = 0; i < k2; i++) {
+				double *xi = Xd + (pe + i) * wd;
+				double *xs = Xs + relmap[rows[p + i]] * w;
+				for (j = 0; j < k1; j++) {
+					double *xj = Xd + (pe + j) * wd;
+					double t = 0;
+					for (r = 0; r < wd; r++)
+						t += xi[r] * xj[r];
+					xs[rows[p + j] - f] -= t;
+				}
+			}
+		}
+		else {
+			// W = D2 * D1', D2 = rows p..md-1 of d, D1 = rows p..q-1
+			Dv = gsl_matrix_view_array(Xd + pe * wd, k2, wd);
+			D1v = gsl_matrix_view_array(Xd + pe * wd, k1, wd);
+			Wv = gsl_matrix_view_array(W, k2, k1);
+			gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, &Dv.matrix, &D1v.matrix, 0.0, &Wv.matrix);
+			for (i = 0; i < k2; i++) {
+				double *xs = Xs + relmap[rows[p + i]] * w;
+				for (j = 0; j < k1; j++)
+					xs[rows[p + j] - f] -= W[i*k1 + j];
+			}
+		}
+
+		// move d to the supernode of its next row
+		U->pos[d] = q;
+		if (q < md)
+			super_link(U, d);
+	}
+
+	// L11 = chol(diagonal block), L21 = X21 * inv(L11')
+	if (!super_dense_chol(Xs, w))
+		return 0;
+	if (m > w) {
+		L11v = gsl_matrix_view_array(Xs, w, w);
+		Bv = gsl_matrix_view_array(Xs + w * w, m - w, w);
+		gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1.0, &L11v.matrix, &Bv.matrix);
+
+		U->pos[s] = Y->rows_ptr[s] + w;
+		super_link(U, s);
+	}
+	return 1;
+}
+
+
+// splits the supernodal elimination tree among the tasks. Subtrees with at
+// most 1 / (SUPER_TASKS_PER_THREAD * threads) of the work become tasks of
+// their own (owner = their root). The supernodes above them are shared and
+// are computed by the task that completes their last child
+static int *super_subtrees(const super_sym *Y, int threads, int *pending) {
+	int S_num = Y->supers_num;
+	int *owner;
+	double *work, total = 0, limit;
+	int s, w, m, c, sp;
+
+	owner = (int *) cs_malloc(S_num, sizeof(int));
+	work = (double *) cs_malloc(S_num, sizeof(double));
+	if (!owner || !work) {
+		cs_free(work);
+		return (cs_free(owner));
+	}
+
+	// flops of every subtree (parents come after their children)
+	for (s = 0; s < S_num; s++) {
+		w = Y->sup_ptr[s+1] - Y->sup_ptr[s];
+		m = Y->rows_ptr[s+1] - Y->rows_ptr[s];
+		work[s] = 0;
+		pending[s] = 0;
+		for (c = 0; c < w; c++)
+			work[s] += (double)(m - c) * (m - c);
+	}
+	for (s = 0; s < S_num; s++) {
+		total += work[s];
+		if (Y->sup_parent[s] != -1)
+			work[Y->sup_parent[s]] += work[s];
+	}
+	limit = total / (SUPER_TASKS_PER_THREAD * threads);
+
+	for (s = S_num - 1; s >= 0; s--) {
+		sp = Y->sup_parent[s];
+		if (work[s] > limit)
+			owner[s] = -1;
+		else if ((sp == -1) || (owner[sp] == -1))
+			owner[s] = s;
+		else
+			owner[s] = owner[sp];
+		if ((sp != -1) && (owner[sp] == -1))
+			pending[sp]++;
+	}
+
+	cs_free(work);
+	return owner;
+}
+
+
+// the failure flag is set and read by the tasks concurrently
+static int super_failed(super_num *U) {
+	int failed;
+
+	#pragma omp atomic read
+	failed = U->failed;
+	return failed;
+}
+
+static void super_fail(super_num *U) {
+
+	#pragma omp atomic write
+	U->failed = 1;
+}
+
+
+// computes task r (a subtree, or a shared supernode without children), then
+// climbs to the shared ancestors whose children are all done
+static void super_task(super_num *U, int r, const int *members, const int *members_ptr,
+		int *pending, int *relmap, double *W) {
+	const super_sym *Y = U->Y;
+	int s, p, left;
+
+	if (U->owner[r] == r) {
+		for (p = members_ptr[r]; p < members_ptr[r+1]; p++) {
+			if (super_failed(U) || !super_node(U, members[p], relmap, W)) {
+				super_fail(U);
+				return;
+			}
+		}
+	}
+	else if (super_failed(U) || !super_node(U, r, relmap, W)) {
+		super_fail(U);
+		return;
+	}
+
+	for (s = r; Y->sup_parent[s] != -1; s = p) {
+		p = Y->sup_parent[s];
+		#pragma omp atomic capture seq_cst
+		left = --pending[p];
+		if (left > 0)
+			return;
+		if (super_failed(U) || !super_node(U, p, relmap, W)) {
+			super_fail(U);
+			return;
+		}
+	}
+}
+
+
+// supernodal left looking Cholesky factorization, L*L' = A(p,p), on the
+// analysis Y of super_analyze (kept by the caller while the pattern of A stays
+// the same). The result has the same layout as the one of cs_chol. Independent
+// subtrees of the elimination tree are factored as parallel tasks.
+// On failure it returns NULL and sets *status to SUPER_NOT_POSDEF or SUPER_NO_MEMORY
+csn *super_chol(const cs *A, const css *S, const super_sym *Y, int *status) {
+	super_num U;
+	csn *N;
+	cs *C, *L;
+	int n, s, f, l, w, m, i, j, p, threads;
+	int *iwork, *relmap, *pending = NULL, *members = NULL, *members_ptr = NULL, *roots = NULL;
+	int roots_num = 0;
+	double *X, *W;
+	int max_m = 0, max_w = 0;
+
+	*status = SUPER_NO_MEMORY;
+	if (!CS_CSC (A) || !S || !Y)
+		return NULL;
+	n = Y->n;
+
+	threads = spmv_get_threads();
+	if ((n < SUPER_PAR_MIN_N) || (Y->supers_num < 2))
+		threads = 1;
+
+	// lower triangle of C = A(p,p), by columns
+	C = cs_symperm(A, S->pinv, 1);
+	L = C ? cs_transpose(C, 1) : NULL;
+	cs_spfree(C);
+	C = L;
+
+	for (s = 0; s < Y->supers_num; s++) {
+		w = Y->sup_ptr[s+1] - Y->sup_ptr[s];
+		m = Y->rows_ptr[s+1] - Y->rows_ptr[s];
+		max_w = (w > max_w) ? w : max_w;
+		max_m = (m > max_m) ? m : max_m;
+	}
+
+	U.Y = Y;
+	U.C = C;
+	U.owner = NULL;
+	U.parallel = (threads > 1);
+	U.failed = 0;
+	X = U.X = (double *) cs_calloc(Y->x_size > 0 ? Y->x_size : 1, sizeof(double));
+	W = (double *) cs_malloc(threads * (max_m * max_w > 0 ? max_m * max_w : 1), sizeof(double));
+	iwork = (int *) cs_malloc(3 * Y->supers_num + threads * n, sizeof(int));
+	N = (csn *) cs_calloc(1, sizeof(csn));
+	if (U.parallel) {
+		pending = (int *) cs_malloc(Y->supers_num, sizeof(int));
+		members = (int *) cs_malloc(Y->supers_num, sizeof(int));
+		members_ptr = (int *) cs_malloc(Y->supers_num + 1, sizeof(int));
+		roots = (int *) cs_malloc(Y->supers_num, sizeof(int));
+		U.owner = pending ? super_subtrees(Y, threads, pending) : NULL;
+	}
+	// the values of L are gathered into a copy of the pattern of the analysis
+	L = cs_spalloc(n, n, Y->L->p[n], 1, 0);
+	if (!C || !X || !W || !iwork || !N || !L ||
+		(U.parallel && (!pending || !members || !members_ptr || !roots || !U.owner))) {
+		U.failed = 1;
+	}
+	else {
+		*status = SUPER_NOT_POSDEF;
+		U.head = iwork;
+		U.next = U.head + Y->supers_num;
+		U.pos = U.next + Y->supers_num;
+		relmap = U.pos + Y->supers_num;
+		for (s = 0; s < Y->supers_num; s++)
+			U.head[s] = -1;
+
+		if (!U.parallel) {
+			for (s = 0; s < Y->supers_num; s++) {
+				if (!super_node(&U, s, relmap, W)) {
+					U.failed = 1;
+					break;
+				}
+			}
+		}
+		else {
+			// supernodes of every task subtree, in increasing order
+			for (s = 0; s <= Y->supers_num; s++)
+				members_ptr[s] = 0;
+			for (s = 0; s < Y->supers_num; s++) {
+				if (U.owner[s] != -1)
+					members_ptr[U.owner[s] + 1]++;
+			}
+			for (s = 0; s < Y->supers_num; s++)
+				members_ptr[s+1] += members_ptr[s];
+			for (s = 0; s < Y->supers_num; s++) {
+				if (U.owner[s] != -1)
+					members[members_ptr[U.owner[s]]++] = s;
+			}
+			for (s = Y->supers_num; s > 0; s--)
+				members_ptr[s] = members_ptr[s-1];
+			members_ptr[0] = 0;
+
+			// task roots, and shared supernodes without children. They are
+			// collected before any task runs: the running tasks decrement pending
+			for (s = 0; s < Y->supers_num; s++) {
+				if ((U.owner[s] == s) || ((U.owner[s] == -1) && (pending[s] == 0)))
+					roots[roots_num++] = s;
+			}
+
+			#pragma omp parallel num_threads(threads)
+			{
+				#pragma omp single
+				{
+					for (i = 0; i < roots_num; i++) {
+						#pragma omp task firstprivate(i)
+						{
+							int t = 0;
+#ifdef _OPENMP
+							t = omp_get_thread_num();
+#endif
+							super_task(&U, roots[i], members, members_ptr, pending,
+									relmap + t * n, W + t * max_m * max_w);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (U.failed) {
+		cs_spfree(C);
+		cs_free(X);
+		cs_free(W);
+		cs_free(iwork);
+		cs_free(N);
+		cs_free(pending);
+		cs_free(members);
+		cs_free(members_ptr);
+		cs_free(roots);
+		cs_free(U.owner);
+		cs_spfree(L);
+		return NULL;
+	}
+
+	// gather the values of L out of the dense blocks
+	memcpy(L->p, Y->L->p, (n + 1)*sizeof(int));
+	memcpy(L->i, Y->L->i, Y->L->p[n]*sizeof(int));
+	for (s = 0; s < Y->supers_num; s++) {
+		f = Y->sup_ptr[s];
+		l = Y->sup_ptr[s+1] - 1;
+		w = l - f + 1;
+		m = Y->rows_ptr[s+1] - Y->rows_ptr[s];
+		for (i = 0; i < m; i++)
+			relmap[Y->rows[Y->rows_ptr[s] + i]] = i;
+		for (j = f; j <= l; j++) {
+			for (p = L->p[j]; p < L->p[j+1]; p++)
+				L->x[p] = X[Y->x_ptr[s] + relmap[L->i[p]] * w + (j - f)];
+		}
+	}
+	N->L = L;
+
+	cs_spfree(C);
+	cs_free(X);
+	cs_free(W);
+	cs_free(iwork);
+	cs_free(pending);
+	cs_free(members);
+	cs_free(members_ptr);
+	cs_free(roots);
+	cs_free(U.owner);
+	*status = SUPER_OK;
+	return N;
+}
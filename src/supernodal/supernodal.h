@@ -0,0 +1,46 @@
+#ifndef _SUPERNODAL_H_
+#define _SUPERNODAL_H_
+
+#include "../csparse/csparse.h"
+
+// columns of a relaxed supernode may carry explicit zeros as long as the
+// supernode stays narrow or the zeros stay a small fraction of its entries
+#define SUPER_RELAX_WIDTH		4
+#define SUPER_RELAX_ZEROS		0.05
+
+// block updates with fewer flops are scattered directly instead of
+// going through dgemm
+#define SUPER_GEMM_MIN_FLOPS	512
+
+// factors smaller than this are computed by a single thread
+#define SUPER_PAR_MIN_N			10000
+// elimination subtrees handed out to the tasks, per thread
+#define SUPER_TASKS_PER_THREAD	4
+
+// status of super_chol
+#define SUPER_OK				0
+#define SUPER_NOT_POSDEF		1
+#define SUPER_NO_MEMORY			2
+
+// supernodal partition of the Cholesky factor L of C = A(p,p).
+// Supernode s holds columns sup_ptr[s] .. sup_ptr[s+1]-1 of L, stored as
+// a dense row major block at x_ptr[s], one row for each of
+// rows[rows_ptr[s] .. rows_ptr[s+1]-1] and one column for each of its columns
+typedef struct super_sym {
+	int n;
+	int supers_num;
+	int *sup_ptr;
+	int *col2sup;		// supernode of every column
+	int *sup_parent;	// supernodal elimination tree (-1: root)
+	int *rows_ptr;
+	int *rows;
+	int *x_ptr;			// start of the dense block of every supernode
+	int x_size;
+	cs *L;				// exact pattern of L (same layout as cs_chol)
+} super_sym;
+
+extern super_sym *super_analyze(const cs *A, const css *S);
+extern csn *super_chol(const cs *A, const css *S, const super_sym *Y, int *status);
+extern void super_sym_free(super_sym *Y);
+
+#endif
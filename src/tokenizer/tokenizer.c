@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tokenizer.h"
+
+
+// maps filename into memory
+tok_file *tok_open(const char *filename) {
+	tok_file *F;
+	struct stat st;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		perror("open");
+		exit(EXIT_FAILURE);
+	}
+	if (fstat(fd, &st) == -1) {
+		perror("fstat");
+		exit(EXIT_FAILURE);
+	}
+
+	F = (tok_file *) malloc(sizeof(tok_file));
+	if (F == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	F->data = NULL;
+	F->size = st.st_size;
+	F->pos = 0;
+	F->released = 0;
+	F->tail = NULL;
+
+	if (F->size > 0) {
+		F->data = (char *) mmap(NULL, F->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (F->data == MAP_FAILED) {
+			perror("mmap");
+			exit(EXIT_FAILURE);
+		}
+		// the file is read once from start to end
+		madvise(F->data, F->size, MADV_SEQUENTIAL);
+	}
+	close(fd);
+
+	return F;
+}
+
+
+// returns the next line of the range [*pos, end) of the file, without its
+// newline and NUL terminated in place, or NULL at the end of the range. The
+// line stays valid until its pages are released. Disjoint ranges can be read
+// concurrently
+char *tok_range_line(tok_file *F, size_t *pos, size_t end) {
+	char *line, *nl;
+	size_t len;
+
+	if (*pos >= end)
+		return NULL;
+
+	line = F->data + *pos;
+	len = end - *pos;
+
+	// memchr scans the bytes with the vector instructions of the machine
+	nl = (char *) memchr(line, '\n', len);
+	if (nl != NULL) {
+		*nl = '\0';
+		*pos += (nl - line) + 1;
+		return line;
+	}
+
+	// a range that does not end at a newline ends the file (only the last
+	// range of a split file can reach here). The last line has no newline
+	// and there may be no room after it
+	*pos = end;
+	F->tail = (char *) malloc(len + 1);
+	if (F->tail == NULL) {
+		printf("Error. Memory allocation problems. Exiting..\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(F->tail, line, len);
+	F->tail[len] = '\0';
+	return F->tail;
+}
+
+
+// gives back the private copies of the pages before end. Their lines must not
+// be used anymore: the pages read the file again if they are touched
+void tok_release(tok_file *F, size_t end) {
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	end -= end % page;
+	if (end > F->released) {
+		madvise(F->data + F->released, end - F->released, MADV_DONTNEED);
+		F->released = end;
+	}
+}
+
+
+// returns the next line of the file, or NULL at the end of the file.
+// The previous lines are given back now and then, so a line stays valid
+// until the next call
+char *tok_next_line(tok_file *F) {
+
+	if (F->pos - F->released >= TOK_RELEASE_SIZE)
+		tok_release(F, F->pos);
+	return tok_range_line(F, &F->pos, F->size);
+}
+
+
+void tok_close(tok_file *F) {
+
+	if (F == NULL)
+		return;
+	if (F->data != NULL)
+		munmap(F->data, F->size);
+	free(F->tail);
+	free(F);
+}
@@ -0,0 +1,29 @@
+#ifndef _TOKENIZER_H_
+#define _TOKENIZER_H_
+
+#include <stddef.h>
+
+// bytes of parsed lines given back by tok_next_line at a time
+#define TOK_RELEASE_SIZE	(4 << 20)
+
+// a netlist mapped into memory. The mapping is private and writable, so the
+// lines are NUL terminated and tokenized in place, without being copied.
+// Writing the NULs turns every page of the file into a private copy, which
+// costs memory like a read of the file would. tok_release gives the copies
+// back once their lines are stored, so the parsers only hold the part of the
+// netlist they are working on
+typedef struct tok_file {
+	char *data;
+	size_t size;
+	size_t pos;			// start of the next line
+	size_t released;	// the pages before it were given back
+	char *tail;			// copy of a last line that has no newline
+} tok_file;
+
+extern tok_file *tok_open(const char *filename);
+extern char *tok_next_line(tok_file *F);
+extern char *tok_range_line(tok_file *F, size_t *pos, size_t end);
+extern void tok_release(tok_file *F, size_t end);
+extern void tok_close(tok_file *F);
+
+#endif
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "trisolve.h"
+#include "../spmv/spmv.h"
+
+
+// computes the level of every row of the system of kind on the triangular
+// factor T (compressed column form). Returns the number of levels
+static int tri_levels(const cs *T, int kind, int *level) {
+	int n = T->n;
+	int *Tp = T->p;
+	int *Ti = T->i;
+	int i, j, p, levels = 0;
+
+	for (i = 0; i < n; i++)
+		level[i] = 0;
+
+	if (kind == TRI_LSOLVE) {
+		// x[j] is final after column j, which updates the rows below it
+		for (j = 0; j < n; j++) {
+			for (p = Tp[j]; p < Tp[j+1]; p++) {
+				i = Ti[p];
+				if ((i > j) && (level[i] < level[j] + 1))
+					level[i] = level[j] + 1;
+			}
+		}
+	}
+	else if (kind == TRI_USOLVE) {
+		// same, from the last column, updating the rows above it
+		for (j = n - 1; j >= 0; j--) {
+			for (p = Tp[j]; p < Tp[j+1]; p++) {
+				i = Ti[p];
+				if ((i < j) && (level[i] < level[j] + 1))
+					level[i] = level[j] + 1;
+			}
+		}
+	}
+	else {
+		// row i of L' is column i of L and depends on the rows below it
+		for (i = n - 1; i >= 0; i--) {
+			for (p = Tp[i]; p < Tp[i+1]; p++) {
+				j = Ti[p];
+				if ((j > i) && (level[i] < level[j] + 1))
+					level[i] = level[j] + 1;
+			}
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (level[i] + 1 > levels)
+			levels = level[i] + 1;
+	}
+	return levels;
+}
+
+
+// builds the level schedule of the solve of kind with the factor T. The
+// schedule keeps a pointer to T, which must outlive it. Returns NULL when out of memory
+tri_sched *tri_sched_init(const cs *T, int kind) {
+	tri_sched *S;
+	int *level, *count;
+	int n = T->n;
+	int i, p, l;
+
+	S = (tri_sched *) calloc(1, sizeof(tri_sched));
+	level = (int *) malloc(n*sizeof(int));
+	if ((S == NULL) || (level == NULL)) {
+		free(S);
+		free(level);
+		return NULL;
+	}
+	S->kind = kind;
+	S->T = T;
+	S->threads = spmv_get_threads();
+	S->levels_num = tri_levels(T, kind, level);
+
+	// small factors and long dependency chains are faster in serial
+	if ((S->threads < 2) || (n < TRI_PAR_MIN_N) ||
+		(n / S->levels_num < TRI_MIN_LEVEL_WIDTH)) {
+		free(level);
+		return S;
+	}
+
+	// the rows of the system
+	if (kind == TRI_LTSOLVE) {
+		S->R = (cs *) T;
+		S->own_R = 0;
+	}
+	else {
+		S->R = cs_transpose(T, 1);
+		S->own_R = 1;
+	}
+
+	S->diag = (int *) malloc(n*sizeof(int));
+	S->level_ptr = (int *) calloc(S->levels_num + 1, sizeof(int));
+	S->level_rows = (int *) malloc(n*sizeof(int));
+	if ((S->R == NULL) || (S->diag == NULL) || (S->level_ptr == NULL) || (S->level_rows == NULL)) {
+		free(level);
+		tri_sched_free(S);
+		return NULL;
+	}
+
+	for (i = 0; i < n; i++) {
+		S->diag[i] = -1;
+		for (p = S->R->p[i]; p < S->R->p[i+1]; p++) {
+			if (S->R->i[p] == i) {
+				S->diag[i] = p;
+				break;
+			}
+		}
+		// structurally zero pivot: leave it to the serial routine
+		if (S->diag[i] < 0) {
+			free(level);
+			if (S->own_R)
+				cs_spfree(S->R);
+			S->R = NULL;
+			return S;
+		}
+	}
+
+	// bucket the rows by level, in increasing row order inside each level
+	count = S->level_ptr;
+	for (i = 0; i < n; i++)
+		count[level[i] + 1]++;
+	for (l = 0; l < S->levels_num; l++)
+		count[l + 1] += count[l];
+	for (i = 0; i < n; i++)
+		S->level_rows[count[level[i]]++] = i;
+	for (l = S->levels_num; l > 0; l--)
+		count[l] = count[l - 1];
+	count[0] = 0;
+
+	free(level);
+	return S;
+}
+
+
+// solves the system of the schedule in place: x holds b on input and the solution on output
+void tri_solve(const tri_sched *S, double *x) {
+	const cs *R = S->R;
+	int levels_num = S->levels_num;
+	int *level_ptr = S->level_ptr;
+	int *level_rows = S->level_rows;
+	int *diag = S->diag;
+
+	if (R == NULL) {
+		if (S->kind == TRI_LSOLVE)
+			cs_lsolve(S->T, x);
+		else if (S->kind == TRI_USOLVE)
+			cs_usolve(S->T, x);
+		else
+			cs_ltsolve(S->T, x);
+		return;
+	}
+
+	#pragma omp parallel num_threads(S->threads)
+	{
+		int *Rp = R->p;
+		int *Ri = R->i;
+		double *Rx = R->x;
+		int l, r, i, p;
+		double sum;
+
+		for (l = 0; l < levels_num; l++) {
+			// the implicit barrier of the loop ends the level
+			#pragma omp for schedule(static)
+			for (r = level_ptr[l]; r < level_ptr[l+1]; r++) {
+				i = level_rows[r];
+				sum = x[i];
+				for (p = Rp[i]; p < diag[i]; p++)
+					sum -= Rx[p] * x[Ri[p]];
+				for (p = diag[i] + 1; p < Rp[i+1]; p++)
+					sum -= Rx[p] * x[Ri[p]];
+				x[i] = sum / Rx[diag[i]];
+			}
+		}
+	}
+}
+
+
+void tri_sched_free(tri_sched *S) {
+	if (S == NULL)
+		return;
+
+	if ((S->own_R) && (S->R))
+		cs_spfree(S->R);
+	free(S->diag);
+	free(S->level_ptr);
+	free(S->level_rows);
+	free(S);
+}
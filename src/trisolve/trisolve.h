@@ -0,0 +1,33 @@
+#ifndef _TRISOLVE_H_
+#define _TRISOLVE_H_
+
+#include "../csparse/csparse.h"
+
+#define TRI_LSOLVE		0	// L*x = b, L lower triangular
+#define TRI_USOLVE		1	// U*x = b, U upper triangular
+#define TRI_LTSOLVE		2	// L'*x = b, L lower triangular
+
+// factors smaller than this, or with fewer rows per level on average,
+// are solved by the serial csparse routines
+#define TRI_PAR_MIN_N			10000
+#define TRI_MIN_LEVEL_WIDTH		64
+
+// level schedule of a triangular solve. The rows of a level only depend on
+// rows of the previous levels, so each level is split among the threads
+typedef struct tri_sched {
+	int kind;			// TRI_LSOLVE, TRI_USOLVE or TRI_LTSOLVE
+	const cs *T;		// the triangular factor, used by the serial path
+	cs *R;				// rows of the system (compressed column form of its transpose). NULL: serial
+	int own_R;			// R was allocated for the schedule
+	int *diag;			// position of the diagonal entry of each row inside R
+	int *level_ptr;		// rows of level l: level_rows[level_ptr[l] .. level_ptr[l+1]-1]
+	int *level_rows;
+	int levels_num;
+	int threads;
+} tri_sched;
+
+extern tri_sched *tri_sched_init(const cs *T, int kind);
+extern void tri_solve(const tri_sched *S, double *x);
+extern void tri_sched_free(tri_sched *S);
+
+#endif
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vecops.h"
+
+
+// returns x.y
+VEC_CLONES
+double vec_dot(unsigned long n, const double *x, const double *y) {
+	unsigned long i;
+	double sum = 0.0;
+
+	#pragma omp simd reduction(+:sum)
+	for (i = 0; i < n; i++)
+		sum += x[i] * y[i];
+
+	return sum;
+}
+
+
+// z = r./d (Jacobi preconditioner) and returns r.z
+VEC_CLONES
+double vec_div_dot(unsigned long n, const double *r, const double *d, double *z) {
+	unsigned long i;
+	double sum = 0.0;
+
+	#pragma omp simd reduction(+:sum)
+	for (i = 0; i < n; i++) {
+		z[i] = r[i] / d[i];
+		sum += r[i] * z[i];
+	}
+
+	return sum;
+}
+
+
+// y = x + beta*y. y is not read when beta is zero
+VEC_CLONES
+void vec_xpby(unsigned long n, const double *x, double beta, double *y) {
+	unsigned long i;
+
+	if (beta == 0.0) {
+		#pragma omp simd
+		for (i = 0; i < n; i++)
+			y[i] = x[i];
+		return;
+	}
+
+	#pragma omp simd
+	for (i = 0; i < n; i++)
+		y[i] = x[i] + beta*y[i];
+}
+
+
+// y = y + alpha*x
+VEC_CLONES
+void vec_axpy(unsigned long n, double alpha, const double *x, double *y) {
+	unsigned long i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++)
+		y[i] += alpha*x[i];
+}
+
+
+// y = alpha*x. x and y may be the same vector
+VEC_CLONES
+void vec_scale(unsigned long n, double alpha, const double *x, double *y) {
+	unsigned long i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++)
+		y[i] = alpha*x[i];
+}
+
+
+// w = y + alpha*x and returns w.w
+VEC_CLONES
+double vec_waxpy_dot(unsigned long n, double alpha, const double *x, const double *y, double *w) {
+	unsigned long i;
+	double sum = 0.0;
+
+	#pragma omp simd reduction(+:sum)
+	for (i = 0; i < n; i++) {
+		w[i] = y[i] + alpha*x[i];
+		sum += w[i] * w[i];
+	}
+
+	return sum;
+}
+
+
+// x = x + alpha*p, r = r - alpha*q and returns r.r (the squared residual norm)
+VEC_CLONES
+double vec_cg_update(unsigned long n, double alpha, const double *p, const double *q, double *x, double *r) {
+	unsigned long i;
+	double sum = 0.0;
+
+	#pragma omp simd reduction(+:sum)
+	for (i = 0; i < n; i++) {
+		x[i] += alpha*p[i];
+		r[i] -= alpha*q[i];
+		sum += r[i] * r[i];
+	}
+
+	return sum;
+}
+
+
+// dots[c] = X(:,c).Y(:,c)
+VEC_CLONES
+void vec_block_dot(unsigned long n, int k, const double *X, const double *Y, double *dots) {
+	unsigned long i;
+	int c;
+
+	for (c = 0; c < k; c++)
+		dots[c] = 0.0;
+
+	for (i = 0; i < n; i++) {
+		#pragma omp simd
+		for (c = 0; c < k; c++)
+			dots[c] += X[i*k + c] * Y[i*k + c];
+	}
+}
+
+
+// Y(:,c) = X(:,c) + beta[c]*Y(:,c). Columns with beta[c] = 0 are copied,
+// so Y may start uninitialised there
+VEC_CLONES
+void vec_block_xpby(unsigned long n, int k, const double *X, const double *beta, double *Y) {
+	unsigned long i;
+	int c;
+
+	for (i = 0; i < n; i++) {
+		#pragma omp simd
+		for (c = 0; c < k; c++)
+			Y[i*k + c] = (beta[c] == 0.0) ? X[i*k + c] : X[i*k + c] + beta[c]*Y[i*k + c];
+	}
+}
+
+
+// X(:,c) += alpha[c]*P(:,c), R(:,c) -= alpha[c]*Q(:,c) and norms[c] = R(:,c).R(:,c).
+// Columns with alpha[c] = 0 (converged) keep X and R whatever P and Q hold
+VEC_CLONES
+void vec_block_cg_update(unsigned long n, int k, const double *alpha, const double *P, const double *Q,
+						 double *X, double *R, double *norms) {
+	unsigned long i;
+	int c;
+
+	for (c = 0; c < k; c++)
+		norms[c] = 0.0;
+
+	for (i = 0; i < n; i++) {
+		#pragma omp simd
+		for (c = 0; c < k; c++) {
+			if (alpha[c] != 0.0) {
+				X[i*k + c] += alpha[c]*P[i*k + c];
+				R[i*k + c] -= alpha[c]*Q[i*k + c];
+			}
+			norms[c] += R[i*k + c] * R[i*k + c];
+		}
+	}
+}
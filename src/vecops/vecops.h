@@ -0,0 +1,28 @@
+#ifndef _VECOPS_H_
+#define _VECOPS_H_
+
+// Fused vector kernels of the Krylov loops. Each one makes a single pass
+// over its vectors and is compiled for AVX-512, AVX2 and plain x86-64, the
+// best version being picked at load time from the cpu features (gcc only)
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define VEC_CLONES	__attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define VEC_CLONES
+#endif
+
+extern double vec_dot(unsigned long n, const double *x, const double *y);
+extern double vec_div_dot(unsigned long n, const double *r, const double *d, double *z);
+extern void vec_xpby(unsigned long n, const double *x, double beta, double *y);
+extern void vec_axpy(unsigned long n, double alpha, const double *x, double *y);
+extern void vec_scale(unsigned long n, double alpha, const double *x, double *y);
+extern double vec_waxpy_dot(unsigned long n, double alpha, const double *x, const double *y, double *w);
+extern double vec_cg_update(unsigned long n, double alpha, const double *p, const double *q, double *x, double *r);
+
+// block versions for k vectors stored by rows (entry (i, c) at [i*k + c]),
+// with one scalar per column
+extern void vec_block_dot(unsigned long n, int k, const double *X, const double *Y, double *dots);
+extern void vec_block_xpby(unsigned long n, int k, const double *X, const double *beta, double *Y);
+extern void vec_block_cg_update(unsigned long n, int k, const double *alpha, const double *P, const double *Q,
+								double *X, double *R, double *norms);
+
+#endif